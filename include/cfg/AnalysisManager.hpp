@@ -0,0 +1,82 @@
+//--------------------------------------------------------------------*- C++ -*-
+// CFG: example of CFG
+//
+// @file AnalysisManager.hpp
+// @brief Cache of the analyses computed over a Function
+
+#ifndef ANALYSISMANAGER_HPP
+#define ANALYSISMANAGER_HPP
+
+#include <cstdint>
+#include <memory>
+#include <typeindex>
+#include <typeinfo>
+#include <unordered_map>
+
+namespace CFG
+{
+    class Function;
+
+    /// @brief Cache of analysis results keyed by the type of the analysis.
+    /// An analysis is any class constructible from `const Function &`.
+    /// Every result remembers the mutation epoch of the function it was
+    /// computed for, a result from an older epoch is recomputed the next
+    /// time it is requested, so the modifications of the graph only have
+    /// to bump the epoch. The cache is not thread safe.
+    class AnalysisManager
+    {
+        /// @brief a cached result
+        struct Entry
+        {
+            /// @brief the result, type erased
+            std::shared_ptr<const void> result;
+            /// @brief epoch of the function when it was computed
+            std::uint64_t epoch{0};
+        };
+
+        /// @brief results by type of analysis
+        std::unordered_map<std::type_index, Entry> results;
+
+    public:
+        /// @brief Get the result of an analysis, computing it if it is
+        /// not cached or it was computed for an older epoch
+        /// @param F function analyzed
+        /// @param epoch current epoch of the function
+        /// @return result of the analysis, valid until the next request
+        /// of the same analysis after a modification of the function
+        template <typename Analysis>
+        const Analysis &get(const Function &F, std::uint64_t epoch)
+        {
+            auto &entry = results[std::type_index(typeid(Analysis))];
+
+            if (!entry.result || entry.epoch != epoch)
+            {
+                entry.result = std::make_shared<const Analysis>(F);
+                entry.epoch = epoch;
+            }
+
+            return *static_cast<const Analysis *>(entry.result.get());
+        }
+
+        /// @brief Is there a valid result for an analysis?
+        /// @param epoch current epoch of the function
+        template <typename Analysis>
+        bool is_cached(std::uint64_t epoch) const
+        {
+            auto it = results.find(std::type_index(typeid(Analysis)));
+            return it != results.end() && it->second.result && it->second.epoch == epoch;
+        }
+
+        /// @brief Drop the result of an analysis
+        template <typename Analysis>
+        void invalidate()
+        {
+            results.erase(std::type_index(typeid(Analysis)));
+        }
+
+        /// @brief Drop every result
+        void clear() { results.clear(); }
+    };
+} // namespace CFG
+
+#endif
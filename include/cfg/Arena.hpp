@@ -0,0 +1,149 @@
+//--------------------------------------------------------------------*- C++ -*-
+// CFG: example of CFG
+//
+// @file Arena.hpp
+// @brief Bump allocator owning the objects and names of a Module
+
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace CFG
+{
+    /// @brief Identifier of an interned edge tag
+    using tag_id_t = std::uint32_t;
+
+    /// @brief Bump allocator, memory is taken from big chunks and it is
+    /// only given back when the arena is destroyed. Objects allocated in
+    /// the arena must still be destroyed by their owner (see ArenaDeleter),
+    /// but releasing the memory is a single operation per chunk.
+    /// The arena is not thread safe.
+    class Arena
+    {
+        /// @brief size of the first chunk, next chunks double it
+        static constexpr std::size_t initial_chunk_size = 16 * 1024;
+        /// @brief maximum size of a chunk, bigger requests get their own chunk
+        static constexpr std::size_t max_chunk_size = 4 * 1024 * 1024;
+
+        /// @brief chunks of memory owned by the arena
+        std::vector<std::unique_ptr<std::byte[]>> chunks;
+        /// @brief current position in the last chunk
+        std::byte *cur{nullptr};
+        /// @brief end of the last chunk
+        std::byte *end{nullptr};
+        /// @brief size for the next chunk
+        std::size_t next_chunk_size{initial_chunk_size};
+        /// @brief total bytes reserved from the system
+        std::size_t bytes_reserved{0};
+        /// @brief total bytes handed out to users
+        std::size_t bytes_used{0};
+        /// @brief strings interned in the arena
+        std::unordered_set<std::string_view> strings;
+        /// @brief edge tags interned with intern_tag, indexed by id
+        std::vector<std::string_view> tags;
+        /// @brief index from tag to its id
+        std::unordered_map<std::string_view, tag_id_t> tag_ids;
+
+        /// @brief Get a new chunk big enough for an allocation
+        /// @param size size of the allocation
+        /// @param align alignment of the allocation
+        void grow(std::size_t size, std::size_t align);
+
+    public:
+        Arena() = default;
+        Arena(const Arena &) = delete;
+        Arena &operator=(const Arena &) = delete;
+        ~Arena() = default;
+
+        /// @brief Allocate raw memory from the arena
+        /// @param size size in bytes
+        /// @param align alignment of the memory
+        /// @return pointer to the memory
+        void *allocate(std::size_t size, std::size_t align = alignof(std::max_align_t))
+        {
+            auto p = reinterpret_cast<std::uintptr_t>(cur);
+            auto aligned = (p + align - 1) & ~(static_cast<std::uintptr_t>(align) - 1);
+
+            if (cur == nullptr || aligned + size > reinterpret_cast<std::uintptr_t>(end))
+            {
+                grow(size, align);
+                p = reinterpret_cast<std::uintptr_t>(cur);
+                aligned = (p + align - 1) & ~(static_cast<std::uintptr_t>(align) - 1);
+            }
+
+            cur = reinterpret_cast<std::byte *>(aligned + size);
+            bytes_used += size;
+            return reinterpret_cast<void *>(aligned);
+        }
+
+        /// @brief Construct an object in the arena
+        /// @param args arguments for the constructor
+        /// @return pointer to the new object
+        template <typename T, typename... Args>
+        T *make(Args &&...args)
+        {
+            return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        }
+
+        /// @brief Copy a string into the arena, equal strings are
+        /// stored only once
+        /// @param str string to intern
+        /// @return view of the interned string, valid while the arena lives
+        std::string_view intern(std::string_view str);
+
+        /// @brief Intern an edge tag and give it a dense id, equal tags
+        /// get the same id, so the blocks store 4 bytes per tag
+        /// @param tag tag to intern
+        /// @return id of the tag, valid while the arena lives
+        tag_id_t intern_tag(std::string_view tag);
+
+        /// @brief Get the string of a tag interned with intern_tag
+        std::string_view get_tag(tag_id_t id) const { return tags[id]; }
+
+        /// @brief Get the bytes reserved from the system by the arena
+        std::size_t get_bytes_reserved() const { return bytes_reserved; }
+
+        /// @brief Get the bytes handed out by the arena
+        std::size_t get_bytes_used() const { return bytes_used; }
+    };
+
+    /// @brief Deleter for objects that can live either in an arena or in
+    /// the heap, arena objects are only destroyed, the arena owns the memory.
+    /// It converts from std::default_delete so std::unique_ptr<T> coming from
+    /// std::make_unique can still be given to the containers.
+    template <typename T>
+    struct ArenaDeleter
+    {
+        /// @brief was the object allocated in an arena?
+        bool arena_owned{false};
+
+        ArenaDeleter() = default;
+
+        ArenaDeleter(std::default_delete<T>) {}
+
+        explicit ArenaDeleter(bool arena_owned) : arena_owned(arena_owned) {}
+
+        void operator()(T *ptr) const
+        {
+            if (arena_owned)
+                ptr->~T();
+            else
+                delete ptr;
+        }
+    };
+
+    /// @brief Owning pointer to an object that may live in an arena
+    template <typename T>
+    using arena_ptr = std::unique_ptr<T, ArenaDeleter<T>>;
+} // namespace CFG
+
+#endif
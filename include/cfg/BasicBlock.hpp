@@ -12,6 +12,13 @@
 #include <string_view>
 #include <cassert>
 #include <fstream>
+#include <memory>
+#include <cstdint>
+
+#include "cfg/Arena.hpp"
+#include "cfg/BitVector.hpp"
+#include "cfg/Instructions.hpp"
+#include "cfg/SmallVector.hpp"
 
 namespace CFG
 {
@@ -19,40 +26,121 @@ namespace CFG
     /// a parent function
     class Function;
 
-    /// @brief Class that represents a basic block
-    /// in the CFG
-    class BasicBlock
+    /// @brief Index of a basic block inside its function
+    using block_id_t = std::uint32_t;
+
+    /// @brief Class that represents a basic block in the CFG. The block is
+    /// aligned to a cache line, and the fields read by the traversals come
+    /// first: the address range and the inline sucessors share the first
+    /// line, the predecessors the second one.
+    class alignas(64) BasicBlock
     {
-        /// @brief Name for the basic block
-        std::string name;
-        /// @brief is entry block?
-        bool entry_block{false};
-        /// @brief is exit block?
-        bool exit_block{false};
+    public:
+        /// @brief Edge in the sucessors of its source: the target, the id of
+        /// the tag in the arena of the function, and the position of the edge
+        /// in the predecessors of the target
+        struct succ_edge_t
+        {
+            BasicBlock *target;
+            tag_id_t tag;
+            std::uint32_t pred_index;
+        };
+
+        /// @brief Edge in the predecessors of its target: the source and the
+        /// position of the edge in the sucessors of the source. With the
+        /// positions of both sides an edge is removed or moved to another
+        /// block without searching the lists.
+        struct pred_edge_t
+        {
+            BasicBlock *source;
+            std::uint32_t succ_index;
+        };
+
+        /// @brief edges kept inside the block in each direction, most
+        /// blocks have one or two, switches spill to the heap
+        static constexpr std::uint32_t inline_edges = 2;
+
+    private:
         /// @brief a start address
         std::uint64_t start_addr{0};
         /// @brief an end address
         std::uint64_t end_addr{0};
+        /// @brief sucessors of the block in insertion order, and its
+        /// predecessors, one per edge, in no particular order. They are
+        /// owned by the parent function and empty while it is finalized.
+        SmallVector<succ_edge_t, inline_edges> succ_edges;
+        /// @brief Index of the block inside its parent function, assigned
+        /// by the function when the block is added, it only changes when
+        /// the function is compacted
+        block_id_t id{0};
+        /// @brief is entry block?
+        bool entry_block{false};
+        /// @brief is exit block?
+        bool exit_block{false};
+        SmallVector<pred_edge_t, inline_edges> pred_edges;
         /// @brief Parent function
         Function *parent_function;
-        /// @brief Here we would write a vector for instructions...
+        /// @brief Name for the basic block, interned in the
+        /// arena of the parent function
+        std::string_view name;
+        /// @brief slice [inst_begin, inst_end) of the instruction
+        /// buffer of the parent function with the instructions of the block
+        std::uint32_t inst_begin{0};
+        std::uint32_t inst_end{0};
+        /// @brief copy of the name of a block created without a parent,
+        /// released when a function adopts the block and interns the name
+        std::unique_ptr<char[]> orphan_name;
+        /// @brief gen and kill sets of the block for the bit vector
+        /// dataflow problems (see Dataflow.hpp), empty until they are set
+        BitVector gen;
+        BitVector kill;
+
+        friend class Function;
 
     public:
         ~BasicBlock() = default;
 
-        void set_entry_block(bool entry_block) { this->entry_block = entry_block; }
+        /// @brief Set if the block is the entry block, the
+        /// parent function keeps count of its entry blocks
+        void set_entry_block(bool entry_block);
 
         bool get_entry_block() const { return entry_block; }
 
-        void set_start_addr(std::uint64_t start_addr) { this->start_addr = start_addr; }
+        /// @brief Set the start address, the address index of
+        /// the parent function is updated
+        void set_start_addr(std::uint64_t start_addr);
 
         std::uint64_t get_start_addr() const { return start_addr; }
 
-        void set_end_addr(std::uint64_t end_addr) { this->end_addr = end_addr; }
+        /// @brief Set the end address (not included in the block),
+        /// the address index of the parent function is updated
+        void set_end_addr(std::uint64_t end_addr);
 
         std::uint64_t get_end_addr() const { return end_addr; }
 
-        const std::string &get_name() const { return name; }
+        std::string_view get_name() const { return name; }
+
+        block_id_t get_id() const { return id; }
+
+        BitVector &get_gen() { return gen; }
+
+        const BitVector &get_gen() const { return gen; }
+
+        BitVector &get_kill() { return kill; }
+
+        const BitVector &get_kill() const { return kill; }
+
+        /// @brief Get the instructions of the block, the view is valid
+        /// until an instruction is added to the function
+        InstructionSlice get_instructions() const;
+
+        /// @brief Add an instruction at the end of the block, instructions
+        /// are expected in increasing address order
+        /// @param opcode opcode of the instruction
+        /// @param address address of the instruction
+        /// @param operands operands of the instruction
+        /// @return true in case there was an error, false other case
+        bool add_instruction(opcode_t opcode, std::uint64_t address, std::span<const operand_t> operands = {});
 
         const Function *getParent() const { return parent_function; }
 
@@ -65,10 +153,11 @@ namespace CFG
                    << "BB-" << name << "\"];\n\n";
         }
 
-        BasicBlock(std::string_view Name, Function *Parent = nullptr) : name(Name), parent_function(Parent) {}
+        BasicBlock(std::string_view Name, Function *Parent = nullptr);
 
     public:
-        /// @brief Static function to create a new basic block
+        /// @brief Static function to create a new basic block, the block
+        /// is allocated in the arena of the parent function
         /// @param Name name given to the basic block
         /// @param Parent parent function of the basic block
         /// @return pointer to a new allocated basic block
@@ -0,0 +1,103 @@
+//--------------------------------------------------------------------*- C++ -*-
+// CFG: example of CFG
+//
+// @file BitVector.hpp
+// @brief Dense bit vector for the dataflow lattices
+
+#ifndef BITVECTOR_HPP
+#define BITVECTOR_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace CFG
+{
+    /// @brief Fixed size set of bits stored as an array of 64 bit words.
+    /// The operations used by the dataflow solver work a word array at a
+    /// time and return whether the destination changed, they use AVX2 when
+    /// the library is built with it (CFG_ENABLE_AVX2) and plain word loops
+    /// otherwise. The bits past the size in the last word are always zero.
+    class BitVector
+    {
+    public:
+        using word_t = std::uint64_t;
+        static constexpr std::size_t word_bits = 64;
+
+    private:
+        std::vector<word_t> words;
+        std::size_t bits{0};
+
+        /// @brief clear the bits past the size in the last word
+        void clear_padding()
+        {
+            if (bits % word_bits)
+                words.back() &= (word_t(1) << (bits % word_bits)) - 1;
+        }
+
+    public:
+        BitVector() = default;
+
+        explicit BitVector(std::size_t bits) : words((bits + word_bits - 1) / word_bits, 0), bits(bits) {}
+
+        /// @brief Are the SIMD versions of the operations compiled in?
+        static bool simd_enabled();
+
+        std::size_t size() const { return bits; }
+
+        bool empty() const { return bits == 0; }
+
+        std::size_t num_words() const { return words.size(); }
+
+        const word_t *data() const { return words.data(); }
+
+        word_t *data() { return words.data(); }
+
+        /// @brief Change the size, new bits are zero
+        void resize(std::size_t new_bits)
+        {
+            words.resize((new_bits + word_bits - 1) / word_bits, 0);
+            bits = new_bits;
+            if (!words.empty())
+                clear_padding();
+        }
+
+        bool test(std::size_t i) const { return (words[i / word_bits] >> (i % word_bits)) & 1; }
+
+        void set(std::size_t i) { words[i / word_bits] |= word_t(1) << (i % word_bits); }
+
+        void reset(std::size_t i) { words[i / word_bits] &= ~(word_t(1) << (i % word_bits)); }
+
+        /// @brief Set every bit to zero
+        void clear() { std::fill(words.begin(), words.end(), 0); }
+
+        /// @brief Set every bit to one
+        void set_all()
+        {
+            std::fill(words.begin(), words.end(), ~word_t(0));
+            if (!words.empty())
+                clear_padding();
+        }
+
+        /// @brief Get the number of bits set
+        std::size_t count() const;
+
+        bool operator==(const BitVector &other) const { return bits == other.bits && words == other.words; }
+
+        /// @brief this |= other, both of the same size
+        /// @return true if this changed
+        bool union_with(const BitVector &other);
+
+        /// @brief this &= other, both of the same size
+        /// @return true if this changed
+        bool intersect_with(const BitVector &other);
+
+        /// @brief this = gen | (in & ~kill), the transfer function of the
+        /// gen/kill problems, all of the same size
+        /// @return true if this changed
+        bool assign_transfer(const BitVector &in, const BitVector &gen, const BitVector &kill);
+    };
+} // namespace CFG
+
+#endif
@@ -0,0 +1,56 @@
+//--------------------------------------------------------------------*- C++ -*-
+// CFG: example of CFG
+//
+// @file BlockOrder.hpp
+// @brief Depth first orders of the blocks of a Function
+
+#ifndef BLOCKORDER_HPP
+#define BLOCKORDER_HPP
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace CFG
+{
+    class Function;
+
+    /// @brief Preorder, postorder and reverse postorder of the blocks
+    /// reachable from the entry block, as arrays of block ids. The depth
+    /// first search visits the sucessors of a block in insertion order.
+    /// The orders are empty when the function has no entry block. Through
+    /// Function::get_analysis the result is computed once and kept until
+    /// the graph changes.
+    class BlockOrder
+    {
+    public:
+        /// @brief position of the blocks not reachable from the entry
+        static constexpr std::uint32_t unreached = ~std::uint32_t(0);
+
+    private:
+        std::vector<std::uint32_t> preorder;
+        std::vector<std::uint32_t> postorder;
+        std::vector<std::uint32_t> reverse_postorder;
+        /// @brief position of each block in the reverse postorder
+        std::vector<std::uint32_t> rpo_index;
+
+    public:
+        explicit BlockOrder(const Function &F);
+
+        std::span<const std::uint32_t> get_preorder() const { return preorder; }
+
+        std::span<const std::uint32_t> get_postorder() const { return postorder; }
+
+        std::span<const std::uint32_t> get_reverse_postorder() const { return reverse_postorder; }
+
+        /// @brief Get the position of a block in the reverse postorder, for
+        /// an edge a->b that is not a back edge rpo(a) < rpo(b)
+        /// @return position, or `unreached` if the block is not reachable
+        std::uint32_t get_rpo_index(std::uint32_t id) const { return rpo_index[id]; }
+
+        /// @brief Is the block reachable from the entry?
+        bool is_reachable(std::uint32_t id) const { return rpo_index[id] != unreached; }
+    };
+} // namespace CFG
+
+#endif
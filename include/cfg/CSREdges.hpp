@@ -0,0 +1,131 @@
+//--------------------------------------------------------------------*- C++ -*-
+// CFG: example of CFG
+//
+// @file CSREdges.hpp
+// @brief Packed (compressed sparse row) storage for the edges of a Function
+
+#ifndef CSREDGES_HPP
+#define CSREDGES_HPP
+
+#include "cfg/BasicBlock.hpp"
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace CFG
+{
+    /// @brief Table of interned edge tags, every different tag
+    /// is stored only once and edges refer to it by its id
+    class TagTable
+    {
+        /// @brief storage of the tags, a deque keeps the strings
+        /// in place so the views from the index stay valid
+        std::deque<std::string> tags;
+        /// @brief index from tag to its id
+        std::unordered_map<std::string_view, tag_id_t> ids;
+
+    public:
+        TagTable() = default;
+
+        /// @brief the index holds views of the own strings,
+        /// so a copy has to build its own index
+        TagTable(const TagTable &other)
+        {
+            *this = other;
+        }
+
+        TagTable &operator=(const TagTable &other)
+        {
+            if (this == &other)
+                return *this;
+            clear();
+            for (const auto &tag : other.tags)
+                intern(tag);
+            return *this;
+        }
+
+        TagTable(TagTable &&) = default;
+        TagTable &operator=(TagTable &&) = default;
+
+        /// @brief Get the id of a tag, inserting it if it does not exist
+        /// @param tag tag to intern
+        /// @return id of the tag
+        tag_id_t intern(std::string_view tag)
+        {
+            auto it = ids.find(tag);
+            if (it != ids.end())
+                return it->second;
+
+            auto id = static_cast<tag_id_t>(tags.size());
+            const auto &stored = tags.emplace_back(tag);
+            ids.emplace(stored, id);
+            return id;
+        }
+
+        /// @brief Get the string of an interned tag
+        /// @param id id of the tag
+        /// @return view of the tag
+        std::string_view get(tag_id_t id) const { return tags[id]; }
+
+        std::size_t size() const { return tags.size(); }
+
+        void clear()
+        {
+            ids.clear();
+            tags.clear();
+        }
+    };
+
+    /// @brief Edges of a function packed in compressed sparse row form.
+    /// The successors of the block with index `i` are stored in the range
+    /// [succ_offsets[i], succ_offsets[i+1]) of succ_targets/succ_tags, the
+    /// same layout is used for the predecessors.
+    struct CSREdges
+    {
+        /// @brief offsets into the successor arrays, one per block plus one
+        std::vector<std::uint32_t> succ_offsets;
+        /// @brief index of the destination block of each edge
+        std::vector<block_id_t> succ_targets;
+        /// @brief interned tag of each edge
+        std::vector<tag_id_t> succ_tags;
+        /// @brief offsets into the predecessor array, one per block plus one
+        std::vector<std::uint32_t> pred_offsets;
+        /// @brief index of the source block of each incoming edge
+        std::vector<block_id_t> pred_sources;
+        /// @brief tags used by the edges
+        TagTable tags;
+
+        std::size_t num_blocks() const { return succ_offsets.empty() ? 0 : succ_offsets.size() - 1; }
+
+        std::size_t num_edges() const { return succ_targets.size(); }
+
+        std::uint32_t succ_begin(block_id_t id) const { return succ_offsets[id]; }
+
+        std::uint32_t succ_end(block_id_t id) const { return succ_offsets[id + 1]; }
+
+        std::uint32_t pred_begin(block_id_t id) const { return pred_offsets[id]; }
+
+        std::uint32_t pred_end(block_id_t id) const { return pred_offsets[id + 1]; }
+
+        void clear()
+        {
+            succ_offsets.clear();
+            succ_offsets.shrink_to_fit();
+            succ_targets.clear();
+            succ_targets.shrink_to_fit();
+            succ_tags.clear();
+            succ_tags.shrink_to_fit();
+            pred_offsets.clear();
+            pred_offsets.shrink_to_fit();
+            pred_sources.clear();
+            pred_sources.shrink_to_fit();
+            tags.clear();
+        }
+    };
+} // namespace CFG
+
+#endif
@@ -0,0 +1,73 @@
+//--------------------------------------------------------------------*- C++ -*-
+// CFG: example of CFG
+//
+// @file CallGraph.hpp
+// @brief Call graph of a Module and its strongly connected components
+
+#ifndef CALLGRAPH_HPP
+#define CALLGRAPH_HPP
+
+#include "cfg/SCC.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace CFG
+{
+    class Function;
+    class Module;
+
+    /// @brief Snapshot of the calls between the functions of a module,
+    /// indexed by function id, with its strongly connected components.
+    /// The calls are the ones of the module, added directly with
+    /// Module::add_call or through the calls of the blocks.
+    /// The components are in topological order, so walking them from the
+    /// last one to the first visits the callees before their callers.
+    /// It must be built again after the calls or the functions change.
+    class CallGraph
+    {
+        /// @brief callees of each function, in CSR form
+        std::vector<std::uint32_t> offsets;
+        std::vector<std::uint32_t> targets;
+        /// @brief components of the graph
+        StronglyConnectedComponents sccs;
+
+    public:
+        explicit CallGraph(const Module &M);
+
+        std::size_t num_functions() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+
+        /// @brief Get the ids of the functions called by a function
+        /// @return pair of pointers with the range of ids
+        std::pair<const std::uint32_t *, const std::uint32_t *> get_callees(std::uint32_t id) const
+        {
+            auto base = targets.data();
+            return {base + offsets[id], base + offsets[id + 1]};
+        }
+
+        /// @brief Get the strongly connected components, the nodes are function ids
+        const StronglyConnectedComponents &get_sccs() const { return sccs; }
+
+        /// @brief Is the function part of a recursive cycle, including calls to itself?
+        bool is_recursive(std::uint32_t id) const { return sccs.is_cyclic(sccs.get_component(id)); }
+
+        /// @brief Run a task on every function, bottom-up: the functions of a
+        /// component start once every component they call has finished, and
+        /// run one after the other in id order. A component is queued as
+        /// soon as its last callee finishes, there are no barriers between
+        /// levels, so independent subtrees run concurrently and the wall
+        /// time is bounded by the longest chain of calls.
+        ///
+        /// Each function is given to a single task, so the task can use the
+        /// analysis cache of its function (dominators, dataflow...) and
+        /// read the results of the callees. Tasks must not throw.
+        /// @param M module the call graph was built from
+        /// @param task task to run on each function
+        /// @param threads number of threads, 0 to use one per hardware thread
+        void run_bottom_up(const Module &M, const std::function<void(Function &)> &task, unsigned threads = 0) const;
+    };
+} // namespace CFG
+
+#endif
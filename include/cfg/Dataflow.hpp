@@ -0,0 +1,258 @@
+//--------------------------------------------------------------------*- C++ -*-
+// CFG: example of CFG
+//
+// @file Dataflow.hpp
+// @brief Worklist solver for forward and backward dataflow problems
+
+#ifndef DATAFLOW_HPP
+#define DATAFLOW_HPP
+
+#include "cfg/BitVector.hpp"
+#include "cfg/Function.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace CFG
+{
+    enum class Direction
+    {
+        Forward,
+        Backward,
+    };
+
+    /// @brief Solution of a dataflow problem over the blocks of a function.
+    ///
+    /// A problem is a class with:
+    ///
+    ///  - `value_t`, the type of the lattice values
+    ///  - `static constexpr Direction direction`
+    ///  - `value_t boundary() const`, the value flowing into the blocks
+    ///    without predecessors (forward) or sucessors (backward)
+    ///  - `value_t initial() const`, the starting value of the other blocks
+    ///  - `bool meet(value_t &into, const value_t &other) const`
+    ///  - `bool transfer(block_id_t id, const value_t &in, value_t &out) const`
+    ///
+    /// where meet and transfer return true if they changed their output.
+    ///
+    /// Blocks are visited in reverse postorder of the graph (of the reversed
+    /// graph for backward problems), unreachable blocks after the rest. The
+    /// solver makes passes over that order and only visits the blocks whose
+    /// input may have changed; a change that flows forward in the order is
+    /// seen in the same pass, so an acyclic graph needs a single pass and a
+    /// loop needs one more per level of nesting that carries new facts.
+    template <typename Problem>
+    class DataflowResult
+    {
+    public:
+        using value_t = typename Problem::value_t;
+
+    private:
+        /// @brief value at the start of each block, in the direction of the problem
+        std::vector<value_t> in;
+        /// @brief value at the end of each block, in the direction of the problem
+        std::vector<value_t> out;
+        /// @brief number of passes until the fixed point
+        std::size_t passes{0};
+        /// @brief number of blocks visited
+        std::size_t visits{0};
+
+    public:
+        DataflowResult(const Function &F, const Problem &P)
+        {
+            constexpr bool forward = Problem::direction == Direction::Forward;
+
+            CSREdges local;
+            const CSREdges *edges = &F.get_csr();
+            if (!F.is_finalized())
+            {
+                F.pack_edges(local);
+                edges = &local;
+            }
+
+            /// the tables are indexed by block id, the ids of deleted
+            /// blocks are left out of the order and never visited
+            const auto n = F.get_block_id_bound();
+            if (n == 0)
+                return;
+
+            /// edges in the direction of the problem
+            const auto &next_offsets = forward ? edges->succ_offsets : edges->pred_offsets;
+            const auto &next = forward ? edges->succ_targets : edges->pred_sources;
+            const auto &prev_offsets = forward ? edges->pred_offsets : edges->succ_offsets;
+            const auto &prev = forward ? edges->pred_sources : edges->succ_targets;
+
+            /// reverse postorder from the roots: the entry block going
+            /// forward, the blocks without sucessors going backward
+            std::vector<block_id_t> order;
+            std::vector<std::uint32_t> position(n, UINT32_MAX);
+            {
+                std::vector<std::pair<block_id_t, std::uint32_t>> stack;
+                auto dfs = [&](block_id_t root)
+                {
+                    if (position[root] != UINT32_MAX)
+                        return;
+                    position[root] = 0;
+                    stack.push_back({root, next_offsets[root]});
+                    while (!stack.empty())
+                    {
+                        auto &[node, edge] = stack.back();
+                        if (edge < next_offsets[node + 1])
+                        {
+                            auto succ = next[edge++];
+                            if (position[succ] == UINT32_MAX)
+                            {
+                                position[succ] = 0;
+                                stack.push_back({succ, next_offsets[succ]});
+                            }
+                            continue;
+                        }
+                        order.push_back(node);
+                        stack.pop_back();
+                    }
+                };
+
+                for (block_id_t id = 0; id < n; id++)
+                {
+                    auto bb = F.get_basic_block(id);
+                    bool root = bb && (forward ? bb->get_entry_block() : next_offsets[id] == next_offsets[id + 1]);
+                    if (root)
+                        dfs(id);
+                }
+                std::reverse(order.begin(), order.end());
+
+                /// blocks not reached from the roots go last, in id order
+                for (block_id_t id = 0; id < n; id++)
+                {
+                    if (position[id] != UINT32_MAX || !F.get_basic_block(id))
+                        continue;
+                    auto begin = order.size();
+                    dfs(id);
+                    std::reverse(order.begin() + begin, order.end());
+                }
+
+                for (std::uint32_t i = 0; i < order.size(); i++)
+                    position[order[i]] = i;
+            }
+
+            in.assign(n, P.initial());
+            out.assign(n, P.initial());
+
+            std::vector<bool> pending(order.size(), true);
+            std::size_t num_pending = order.size();
+            value_t scratch = P.initial();
+
+            while (num_pending)
+            {
+                passes++;
+
+                for (std::uint32_t i = 0; i < order.size() && num_pending; i++)
+                {
+                    if (!pending[i])
+                        continue;
+                    pending[i] = false;
+                    num_pending--;
+                    visits++;
+
+                    auto id = order[i];
+                    auto first = prev_offsets[id], last = prev_offsets[id + 1];
+                    bool root = first == last || (forward && F.get_basic_block(id)->get_entry_block());
+
+                    if (root)
+                        scratch = P.boundary();
+                    else
+                        scratch = out[prev[first++]];
+                    for (; first < last; first++)
+                        P.meet(scratch, out[prev[first]]);
+                    in[id] = scratch;
+
+                    if (!P.transfer(id, in[id], out[id]))
+                        continue;
+
+                    for (auto e = next_offsets[id]; e < next_offsets[id + 1]; e++)
+                    {
+                        auto pos = position[next[e]];
+                        if (!pending[pos])
+                        {
+                            pending[pos] = true;
+                            num_pending++;
+                        }
+                    }
+                }
+            }
+        }
+
+        /// @brief Get the value at the start of a block, for backward
+        /// problems the start is the end of the block in program order
+        const value_t &get_in(block_id_t id) const { return in[id]; }
+
+        /// @brief Get the value at the end of a block, for backward
+        /// problems the end is the start of the block in program order
+        const value_t &get_out(block_id_t id) const { return out[id]; }
+
+        std::size_t get_passes() const { return passes; }
+
+        std::size_t get_visits() const { return visits; }
+    };
+
+    enum class Meet
+    {
+        Union,
+        Intersection,
+    };
+
+    /// @brief Bit vector problem whose transfer function is
+    /// out = gen | (in & ~kill), with the gen and kill sets stored in the
+    /// blocks. The sets of a block are either empty or of `bits` bits.
+    template <Direction Dir, Meet M>
+    class GenKillProblem
+    {
+        const Function &F;
+        std::size_t bits;
+        /// @brief used for the blocks without gen or kill set
+        BitVector zero;
+
+    public:
+        using value_t = BitVector;
+        static constexpr Direction direction = Dir;
+
+        GenKillProblem(const Function &F, std::size_t bits) : F(F), bits(bits), zero(bits) {}
+
+        value_t boundary() const { return BitVector(bits); }
+
+        value_t initial() const
+        {
+            BitVector value(bits);
+            if (M == Meet::Intersection)
+                value.set_all();
+            return value;
+        }
+
+        bool meet(value_t &into, const value_t &other) const
+        {
+            return M == Meet::Union ? into.union_with(other) : into.intersect_with(other);
+        }
+
+        bool transfer(block_id_t id, const value_t &in, value_t &out) const
+        {
+            auto bb = F.get_basic_block(id);
+            const auto &gen = bb->get_gen().empty() ? zero : bb->get_gen();
+            const auto &kill = bb->get_kill().empty() ? zero : bb->get_kill();
+            return out.assign_transfer(in, gen, kill);
+        }
+    };
+
+    /// @brief Live variables, gen are the variables used before being
+    /// defined in the block and kill the variables defined in it
+    using LivenessProblem = GenKillProblem<Direction::Backward, Meet::Union>;
+
+    /// @brief Reaching definitions, gen are the definitions of the
+    /// block that reach its end and kill the others of the same variables
+    using ReachingDefinitionsProblem = GenKillProblem<Direction::Forward, Meet::Union>;
+
+    /// @brief Available expressions, gen are the expressions computed in
+    /// the block and kill the ones whose operands are redefined
+    using AvailableExpressionsProblem = GenKillProblem<Direction::Forward, Meet::Intersection>;
+} // namespace CFG
+
+#endif
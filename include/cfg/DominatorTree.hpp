@@ -0,0 +1,113 @@
+//--------------------------------------------------------------------*- C++ -*-
+// CFG: example of CFG
+//
+// @file DominatorTree.hpp
+// @brief Dominator and post-dominator trees of a Function
+
+#ifndef DOMINATORTREE_HPP
+#define DOMINATORTREE_HPP
+
+#include "cfg/BasicBlock.hpp"
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace CFG
+{
+    class Function;
+
+    /// @brief Dominator tree of the blocks of a function, computed with the
+    /// Lengauer-Tarjan algorithm (with balanced path compression) over the
+    /// block ids. The tree is numbered with a depth first search so
+    /// dominance queries are constant time, and the dominance frontiers
+    /// are computed with the method of Cooper, Harvey and Kennedy.
+    ///
+    /// A post-dominator tree is built over the reversed graph, with a
+    /// virtual exit node connected from every block without sucessors.
+    /// Blocks that cannot reach an exit are not post-dominated by any block.
+    class DominatorTree
+    {
+    public:
+        /// @brief id used for the missing immediate dominators
+        static constexpr block_id_t invalid = std::numeric_limits<block_id_t>::max();
+
+    private:
+        /// @brief is this a post-dominator tree?
+        bool post;
+        /// @brief root of the tree, the entry block or the virtual exit
+        block_id_t root{invalid};
+        /// @brief immediate dominator of each block
+        std::vector<block_id_t> idom;
+        /// @brief preorder number of each block in the tree
+        std::vector<std::uint32_t> pre;
+        /// @brief postorder number of each block in the tree
+        std::vector<std::uint32_t> post_number;
+        /// @brief children of each block in the tree, in CSR form
+        std::vector<std::uint32_t> children_offsets;
+        std::vector<block_id_t> children;
+        /// @brief dominance frontier of each block, in CSR form
+        std::vector<std::uint32_t> frontier_offsets;
+        std::vector<block_id_t> frontier;
+
+    public:
+        /// @brief Compute the tree for a function
+        /// @param F function to analyze
+        /// @param post compute the post-dominator tree instead
+        explicit DominatorTree(const Function &F, bool post = false);
+
+        bool is_post_dominator_tree() const { return post; }
+
+        /// @brief Get the number of blocks covered, for post-dominators
+        /// it includes the virtual exit node, whose id is get_root()
+        std::size_t size() const { return idom.size(); }
+
+        /// @brief Get the root of the tree
+        block_id_t get_root() const { return root; }
+
+        /// @brief Is the block reachable from the root of the tree?
+        bool is_reachable(block_id_t id) const { return id < idom.size() && (id == root || idom[id] != invalid); }
+
+        /// @brief Get the immediate dominator of a block
+        /// @return immediate dominator, invalid for the root and unreachable blocks
+        block_id_t get_idom(block_id_t id) const { return idom[id]; }
+
+        /// @brief Does block `a` dominate block `b`? every block dominates itself
+        bool dominates(block_id_t a, block_id_t b) const
+        {
+            if (!is_reachable(a) || !is_reachable(b))
+                return false;
+            return pre[a] <= pre[b] && post_number[b] <= post_number[a];
+        }
+
+        bool strictly_dominates(block_id_t a, block_id_t b) const { return a != b && dominates(a, b); }
+
+        bool dominates(const BasicBlock *a, const BasicBlock *b) const { return dominates(a->get_id(), b->get_id()); }
+
+        /// @brief Get the children of a block in the tree
+        /// @return pair of pointers with the range of children
+        std::pair<const block_id_t *, const block_id_t *> get_children(block_id_t id) const
+        {
+            auto base = children.data();
+            return {base + children_offsets[id], base + children_offsets[id + 1]};
+        }
+
+        /// @brief Get the dominance frontier of a block
+        /// @return pair of pointers with the range of blocks in the frontier
+        std::pair<const block_id_t *, const block_id_t *> get_frontier(block_id_t id) const
+        {
+            auto base = frontier.data();
+            return {base + frontier_offsets[id], base + frontier_offsets[id + 1]};
+        }
+    };
+
+    /// @brief Post-dominator tree, a different type so it
+    /// can be cached apart from the dominator tree
+    class PostDominatorTree : public DominatorTree
+    {
+    public:
+        explicit PostDominatorTree(const Function &F) : DominatorTree(F, true) {}
+    };
+} // namespace CFG
+
+#endif
@@ -0,0 +1,227 @@
+//--------------------------------------------------------------------*- C++ -*-
+// CFG: example of CFG
+//
+// @file Exporter.hpp
+// @brief Buffered export of functions and modules as DOT, JSON or edge list
+
+#ifndef EXPORTER_HPP
+#define EXPORTER_HPP
+
+#include <cassert>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "exceptions/serialization_exception.hpp"
+
+namespace CFG
+{
+    class Function;
+    class Module;
+
+    /// @brief Destination of the exported text
+    class OutputSink
+    {
+    public:
+        virtual ~OutputSink() = default;
+
+        /// @brief Write a chunk of text
+        virtual void write(const char *data, std::size_t size) = 0;
+    };
+
+    /// @brief Sink writing to a C++ stream
+    class StreamSink : public OutputSink
+    {
+        std::ostream &stream;
+
+    public:
+        explicit StreamSink(std::ostream &stream) : stream(stream) {}
+
+        void write(const char *data, std::size_t size) override
+        {
+            stream.write(data, static_cast<std::streamsize>(size));
+        }
+    };
+
+    /// @brief Sink writing to a file
+    class FileSink : public OutputSink
+    {
+        std::FILE *file;
+
+    public:
+        /// @brief Open the file, truncating it
+        /// @throw exceptions::SerializationException if it cannot be opened
+        explicit FileSink(const std::string &path);
+
+        FileSink(const FileSink &) = delete;
+        FileSink &operator=(const FileSink &) = delete;
+
+        /// @brief Close the file if close() was not called, errors are
+        /// ignored as a destructor cannot report them
+        ~FileSink() override;
+
+        void write(const char *data, std::size_t size) override;
+
+        /// @brief Close the file, the data buffered by the C library is
+        /// written here and can still fail
+        /// @throw exceptions::SerializationException if the file cannot be closed
+        void close();
+    };
+
+    /// @brief Text buffer in front of a sink, the text is formatted in the
+    /// buffer (numbers with std::to_chars) and given to the sink in big
+    /// chunks. The buffer can be reused with different sinks. The pending
+    /// text must be given to the sink with flush() to see the errors of the
+    /// sink, the destructor flushes too but it ignores them.
+    class OutputBuffer
+    {
+        OutputSink *sink;
+        std::vector<char> buffer;
+        std::size_t used{0};
+
+        /// @brief Make room for `size` bytes, flushing if needed
+        char *reserve(std::size_t size)
+        {
+            if (used + size > buffer.size())
+            {
+                flush();
+                if (size > buffer.size())
+                    buffer.resize(size);
+            }
+            return buffer.data() + used;
+        }
+
+    public:
+        /// @brief default size of the buffer
+        static constexpr std::size_t default_capacity = 1 << 20;
+
+        explicit OutputBuffer(OutputSink &sink, std::size_t capacity = default_capacity)
+            : sink(&sink), buffer(capacity) {}
+
+        OutputBuffer(const OutputBuffer &) = delete;
+        OutputBuffer &operator=(const OutputBuffer &) = delete;
+
+        ~OutputBuffer()
+        {
+            try
+            {
+                flush();
+            }
+            catch (...)
+            {
+            }
+        }
+
+        /// @brief Flush the pending text and change the sink
+        void set_sink(OutputSink &new_sink)
+        {
+            flush();
+            sink = &new_sink;
+        }
+
+        /// @brief Give the pending text to the sink
+        void flush()
+        {
+            if (used)
+                sink->write(buffer.data(), used);
+            used = 0;
+        }
+
+        OutputBuffer &write(std::string_view str)
+        {
+            auto dst = reserve(str.size());
+            str.copy(dst, str.size());
+            used += str.size();
+            return *this;
+        }
+
+        OutputBuffer &write(char c)
+        {
+            *reserve(1) = c;
+            used++;
+            return *this;
+        }
+
+        /// @brief Write an unsigned number in the given base
+        /// @param base base between 2 and 36
+        OutputBuffer &write_uint(std::uint64_t value, int base = 10)
+        {
+            assert(base >= 2 && base <= 36 && "invalid base");
+            /// enough for the 64 digits of base 2
+            auto dst = reserve(64);
+            auto result = std::to_chars(dst, dst + 64, value, base);
+            assert(result.ec == std::errc() && "number does not fit");
+            used += result.ptr - dst;
+            return *this;
+        }
+
+        /// @brief Write a string escaping the double quotes, backslashes
+        /// and control characters, as JSON does
+        OutputBuffer &write_escaped(std::string_view str);
+
+        /// @brief Write an escaped string between double quotes
+        OutputBuffer &write_quoted(std::string_view str)
+        {
+            return write('"').write_escaped(str).write('"');
+        }
+
+        /// @brief Write a string for a quoted Graphviz string, Graphviz
+        /// has no escape for control characters so the double quotes,
+        /// backslashes and newlines are escaped and the rest of the
+        /// control characters are written as spaces
+        OutputBuffer &write_dot_escaped(std::string_view str);
+
+        /// @brief Write a Graphviz string between double quotes
+        OutputBuffer &write_dot_quoted(std::string_view str)
+        {
+            return write('"').write_dot_escaped(str).write('"');
+        }
+    };
+
+    /// @brief Formats of the exporter
+    enum class ExportFormat
+    {
+        /// @brief Graphviz, one digraph per function
+        Dot,
+        /// @brief JSON object with the blocks and the edges of each function
+        Json,
+        /// @brief line oriented text, one line per block and per edge:
+        ///
+        ///     module "<name>"
+        ///     function "<name>"
+        ///     block <id> "<name>" <start-addr in hex> <end-addr in hex> [entry]
+        ///     edge <src-id> <dst-id> "<tag>"
+        ///     end
+        EdgeList,
+    };
+
+    /// @brief Export a function, blocks are written by id and edges by
+    /// source block id and then in insertion order, so the output only
+    /// depends on the graph. The text may be left in the buffer.
+    /// @param F function to export
+    /// @param out buffer where the text is written
+    /// @param format format of the output
+    void export_function(const Function &F, OutputBuffer &out, ExportFormat format);
+
+    /// @brief Export all the functions of a module, in module order, the
+    /// buffer is flushed at the end
+    /// @param M module to export
+    /// @param out buffer where the text is written
+    /// @param format format of the output
+    void export_module(const Module &M, OutputBuffer &out, ExportFormat format);
+
+    /// @brief Export every function of a module to its own file, the files
+    /// are written in parallel and named <directory>/<index>-<name>.<ext>
+    /// @param M module to export
+    /// @param directory existing directory for the files
+    /// @param format format of the output
+    /// @param threads number of threads, 0 to use one per hardware thread
+    void export_module_split(const Module &M, const std::string &directory, ExportFormat format, unsigned threads = 0);
+} // namespace CFG
+
+#endif
@@ -7,7 +7,17 @@
 #ifndef FUNCTION_HPP
 #define FUNCTION_HPP
 
+#include "cfg/AnalysisManager.hpp"
+#include "cfg/Arena.hpp"
 #include "cfg/BasicBlock.hpp"
+#include "cfg/BlockOrder.hpp"
+#include "cfg/CSREdges.hpp"
+#include "cfg/DominatorTree.hpp"
+#include "cfg/LoopInfo.hpp"
+#include "cfg/Reachability.hpp"
+#include "cfg/SCC.hpp"
+#include "cfg/SlotRange.hpp"
+#include "cfg/Stats.hpp"
 #include "exceptions/noentryblock_exception.hpp"
 #include "exceptions/noconnectedblock_exception.hpp"
 #include "exceptions/multipleentryblock_exception.hpp"
@@ -20,7 +30,11 @@
 #include <algorithm>
 #include <unordered_map>
 #include <fstream>
-#include <set>
+#include <map>
+#include <iterator>
+#include <ranges>
+#include <span>
+#include <functional>
 
 namespace CFG
 {
@@ -30,95 +44,582 @@ namespace CFG
 
     class Function
     {
-        /// @brief Name for the function
-        std::string name;
-        /// @brief Vector of unique pointers of basic blocks
-        std::vector<std::unique_ptr<BasicBlock>> basic_blocks;
+    public:
+        /// @brief Owning pointer to a block, blocks live in the arena
+        using block_ptr_t = arena_ptr<BasicBlock>;
+
+        /// @brief Edge given to add_successors
+        struct Edge
+        {
+            BasicBlock *src;
+            BasicBlock *dst;
+            std::string_view tag;
+        };
+
+        /// @brief Callback called by compact() for every block that changes
+        /// its id, in increasing order of id, `new_id` is never greater than
+        /// `old_id`. A table indexed by block id is kept in sync with
+        /// `table[new_id] = table[old_id];` and resizing it afterwards to
+        /// get_block_id_bound()
+        using block_remap_t = std::function<void(block_id_t old_id, block_id_t new_id)>;
+
+    private:
+        using succ_edge_t = BasicBlock::succ_edge_t;
+        using pred_edge_t = BasicBlock::pred_edge_t;
+
+    public:
+        /// @brief Iterator over the blocks at the other end of the edges
+        /// of a block, it reads the edge lists of the function in place
+        class BlockIterator
+        {
+            enum class kind_t : std::uint8_t
+            {
+                Sucessors,
+                Predecessors,
+                Packed,
+            };
+
+            union
+            {
+                const succ_edge_t *succ;
+                const pred_edge_t *pred;
+                const block_id_t *packed;
+            };
+            /// @brief blocks of the function, for the packed edges
+            const block_ptr_t *blocks{nullptr};
+            kind_t kind{kind_t::Packed};
+
+            friend class Function;
+
+            explicit BlockIterator(const succ_edge_t *succ) : succ(succ), kind(kind_t::Sucessors) {}
+
+            explicit BlockIterator(const pred_edge_t *pred) : pred(pred), kind(kind_t::Predecessors) {}
+
+            BlockIterator(const block_id_t *packed, const block_ptr_t *blocks) : packed(packed), blocks(blocks) {}
+
+            const void *position() const
+            {
+                switch (kind)
+                {
+                case kind_t::Sucessors:
+                    return succ;
+                case kind_t::Predecessors:
+                    return pred;
+                default:
+                    return packed;
+                }
+            }
+
+        public:
+            using value_type = BasicBlock *;
+            using difference_type = std::ptrdiff_t;
+            using iterator_concept = std::forward_iterator_tag;
+            using iterator_category = std::forward_iterator_tag;
+
+            BlockIterator() : packed(nullptr) {}
+
+            BasicBlock *operator*() const;
+
+            BlockIterator &operator++()
+            {
+                switch (kind)
+                {
+                case kind_t::Sucessors:
+                    ++succ;
+                    break;
+                case kind_t::Predecessors:
+                    ++pred;
+                    break;
+                default:
+                    ++packed;
+                }
+                return *this;
+            }
+
+            BlockIterator operator++(int)
+            {
+                auto old = *this;
+                ++*this;
+                return old;
+            }
+
+            bool operator==(const BlockIterator &other) const { return position() == other.position(); }
+        };
+
+        /// @brief Range of the sucessors or predecessors of a block, a view
+        /// of the edge lists that allocates nothing. It is invalidated by
+        /// any modification of the graph and by finalize().
+        class BlockRange : public std::ranges::view_interface<BlockRange>
+        {
+            BlockIterator first;
+            BlockIterator last;
+            std::size_t count{0};
+
+        public:
+            BlockRange() = default;
+
+            BlockRange(BlockIterator first, BlockIterator last, std::size_t count)
+                : first(first), last(last), count(count) {}
+
+            BlockIterator begin() const { return first; }
+
+            BlockIterator end() const { return last; }
+
+            std::size_t size() const { return count; }
+        };
+
+    private:
+        /// @brief Arena used when the function has no parent module
+        std::unique_ptr<Arena> own_arena;
+        /// @brief Arena for the blocks and names of the function,
+        /// the one of the parent module or the own one
+        Arena *arena;
+        /// @brief Name for the function, interned in the arena
+        std::string_view name;
+        /// @brief Blocks of the function indexed by id, a deleted block
+        /// leaves its slot empty until the function is compacted
+        std::vector<block_ptr_t> basic_blocks;
+        /// @brief number of blocks in `basic_blocks`, the empty slots excluded
+        std::size_t block_count{0};
         /// @brief Parent module
         Module *parent_module;
+        /// @brief Index of the function inside its parent module, it
+        /// only changes when the module is compacted
+        std::uint32_t id{0};
+
+        friend class BasicBlock;
+        friend class Module;
+
+        /// @brief packed edges, only valid once the function is finalized
+        CSREdges csr;
+
+        /// @brief is the function finalized? In that case the edges live
+        /// in `csr` and the edge lists of the blocks are empty
+        bool finalized{false};
+
+        /// @brief Move the edges from the packed form back to the blocks so
+        /// the function can be modified again, nothing is done if the
+        /// function is not finalized
+        void thaw();
+
+        /// @brief instructions of all the blocks, each block has a slice
+        InstructionBuffer instructions;
+        /// @brief instructions no longer used by any block, left behind
+        /// by deleted blocks and by slices moved to the end of the buffer
+        std::uint32_t dead_instructions{0};
+
+        /// @brief Add an instruction at the end of a block. The slice of the
+        /// block is moved to the end of the buffer first when another slice
+        /// follows it, so filling the blocks one after the other, as a lifter
+        /// does, never copies. The buffer is compacted when more than half of
+        /// it is dead.
+        /// @return true in case there was an error, false other case
+        bool append_instruction(BasicBlock *bb, opcode_t opcode, std::uint64_t address, std::span<const operand_t> operands);
 
-        using tag_bb_t = std::pair<std::string, BasicBlock *>;
+        /// @brief functions called by each block, see add_call
+        std::unordered_map<const BasicBlock *, std::vector<Function *>> call_sites;
 
-        using edges_t = std::unordered_map<BasicBlock *, std::vector<tag_bb_t>>;
+        /// @brief number of blocks calling each function, the module keeps
+        /// the call between both functions while it is not zero
+        std::unordered_map<const Function *, std::uint32_t> callee_blocks;
 
-        /// @brief list of sucessors
-        edges_t sucessors;
+        /// @brief Move the calls of `b` to `a` before `b` is merged into it,
+        /// the calls `a` already makes are not repeated
+        void move_call_sites(const BasicBlock *b, const BasicBlock *a);
 
-        std::unordered_map<BasicBlock *, std::vector<BasicBlock *>> predecessor;
+        /// @brief Drop the calls of a block, the calls between the functions
+        /// that no other block makes are removed from the module
+        void drop_call_sites(const BasicBlock *bb);
+
+        /// @brief Drop the calls of every block to a function, used by the
+        /// module when the function is deleted
+        void drop_calls_to(const Function *callee);
+
+        /// @brief blocks indexed by name, a view of the name of the
+        /// block is used as key
+        std::unordered_multimap<std::string_view, BasicBlock *> blocks_by_name;
+
+        /// @brief blocks indexed by start address, only blocks with a
+        /// non empty [start_addr, end_addr) range are indexed
+        std::multimap<std::uint64_t, BasicBlock *> blocks_by_addr;
+
+        /// @brief Add an edge at the end of the sucessors of `src`
+        /// @param tag id of the tag of the edge in the arena
+        void link(BasicBlock *src, BasicBlock *dst, tag_id_t tag)
+        {
+            auto &succs = src->succ_edges;
+            auto &preds = dst->pred_edges;
+            succs.push_back({dst, tag, static_cast<std::uint32_t>(preds.size())});
+            preds.push_back({src, static_cast<std::uint32_t>(succs.size() - 1)});
+        }
+
+        /// @brief Remove an edge. The predecessor entry is replaced by the
+        /// last one of its list, the sucessors keep their order, so the cost
+        /// is the number of sucessors of `src` after the removed one
+        /// @param src source of the edge
+        /// @param succ_index position of the edge in the sucessors of `src`
+        void unlink(BasicBlock *src, std::uint32_t succ_index)
+        {
+            auto &succs = src->succ_edges;
+            auto edge = succs[succ_index];
+
+            auto &preds = edge.target->pred_edges;
+            auto moved = preds.back();
+            preds[edge.pred_index] = moved;
+            moved.source->succ_edges[moved.succ_index].pred_index = edge.pred_index;
+            preds.pop_back();
+
+            succs.erase(succs.begin() + succ_index);
+            for (auto i = succ_index; i < succs.size(); i++)
+                succs[i].target->pred_edges[succs[i].pred_index].succ_index = i;
+        }
+
+        /// @brief Give the sucessors of `from` to `to`, which must have none,
+        /// only the predecessor entries of the moved edges are rewritten
+        void move_sucessors(BasicBlock *from, BasicBlock *to)
+        {
+            to->succ_edges = std::move(from->succ_edges);
+
+            for (const auto &succ : to->succ_edges)
+                succ.target->pred_edges[succ.pred_index].source = to;
+        }
+
+        /// @brief Get the block that merge_blocks can merge into `a`
+        /// @return the only sucessor of `a` if `a` is its only predecessor
+        /// and it is not the entry block, nullptr other case
+        BasicBlock *chain_sucessor(BasicBlock *a) const
+        {
+            if (a->succ_edges.size() != 1)
+                return nullptr;
+
+            auto b = a->succ_edges[0].target;
+            if (b == a || b->get_entry_block() || b->pred_edges.size() != 1)
+                return nullptr;
+            return b;
+        }
 
         void delete_block_links(BasicBlock *bb)
         {
-            for (auto pred : predecessor[bb])
+            /// the sucessors are removed from the last one so nothing is
+            /// shifted, a self loop also leaves the predecessors of the block
+            for (auto i = bb->succ_edges.size(); i-- > 0;)
+                unlink(bb, i);
+
+            /// remove the block from the sucessors of its predecessors
+            while (!bb->pred_edges.empty())
+                unlink(bb->pred_edges.back().source, bb->pred_edges.back().succ_index);
+
+            bb->succ_edges.reset();
+            bb->pred_edges.reset();
+        }
+
+        void index_address(BasicBlock *bb)
+        {
+            if (bb->get_end_addr() > bb->get_start_addr())
+                blocks_by_addr.emplace(bb->get_start_addr(), bb);
+        }
+
+        void unindex_address(BasicBlock *bb)
+        {
+            auto range = blocks_by_addr.equal_range(bb->get_start_addr());
+            for (auto it = range.first; it != range.second; ++it)
             {
-                /// get the list of sucessors from predecessors
-                auto &pred_successors = sucessors[pred];
+                if (it->second == bb)
+                {
+                    blocks_by_addr.erase(it);
+                    return;
+                }
+            }
+        }
+
+        /// @brief called by compact() for every renumbered block, see block_remap_t
+        block_remap_t on_block_remap;
 
-                /// look for the block to delete
-                auto it = std::find_if(pred_successors.begin(), pred_successors.end(), [=](tag_bb_t &p)
-                                       { return p.second == bb; });
+        /// @brief Remove the block with the given id. Its slot is left empty
+        /// so the ids and the order of the other blocks do not change, the
+        /// empty slots at the end of the blocks are dropped right away and
+        /// the rest are reclaimed by compact()
+        /// @param id id of the block to remove
+        void remove_basic_block(block_id_t id)
+        {
+            thaw();
+            invalidate_analyses();
 
-                /// now delete the block from the list of its sucessors
-                if (it != pred_successors.end())
-                    pred_successors.erase(it);
+            auto bb = basic_blocks[id].get();
+
+            if (bb->get_entry_block())
+            {
+                entry_count--;
+                reachability_valid = false;
+            }
+
+            /// the sucessors of a reachable block may lose their
+            /// reachability, they are the start of the region to recheck
+            bool was_reachable = reachability_valid && reachable[id];
+            std::vector<BasicBlock *> region;
+            if (was_reachable)
+            {
+                for (auto &succ : bb->succ_edges)
+                    if (succ.target != bb)
+                        region.push_back(succ.target);
+            }
+
+            delete_block_links(bb);
+
+            auto range = blocks_by_name.equal_range(bb->get_name());
+            for (auto it = range.first; it != range.second; ++it)
+            {
+                if (it->second == bb)
+                {
+                    blocks_by_name.erase(it);
+                    break;
+                }
+            }
+
+            unindex_address(bb);
+
+            dead_instructions += bb->inst_end - bb->inst_begin;
+
+            drop_call_sites(bb);
+
+            basic_blocks[id].reset();
+            reachable[id] = false;
+            block_count--;
+
+            while (!basic_blocks.empty() && !basic_blocks.back())
+            {
+                basic_blocks.pop_back();
+                reachable.pop_back();
+            }
+
+            if (was_reachable)
+            {
+                reachable_count--;
+                recheck_reachability(region);
             }
-            /// delete the predecessor
-            predecessor.erase(bb);
-            /// now delete the sucessors
-            sucessors.erase(bb);
+        }
+
+        /// @brief number of blocks marked as entry block
+        std::size_t entry_count{0};
+        /// @brief blocks reachable from the entry block, indexed by id.
+        /// It is kept up to date by the modifications of the graph while
+        /// `reachability_valid` is true, and fully recomputed otherwise
+        mutable std::vector<bool> reachable;
+        /// @brief number of blocks set in `reachable`
+        mutable std::size_t reachable_count{0};
+        /// @brief does `reachable` describe the current graph?
+        mutable bool reachability_valid{false};
+        /// @brief entry block used to compute `reachable`
+        mutable const BasicBlock *reachability_root{nullptr};
+        /// @brief stack reused by the incremental updates
+        mutable std::vector<block_id_t> reachability_todo;
+
+        /// @brief mutation epoch, incremented by every modification of
+        /// the graph, the cached analyses from older epochs are stale
+        std::uint64_t epoch{0};
+        /// @brief cached analyses of the function
+        mutable AnalysisManager analyses;
+
+        /// @brief Mark the cached analyses as stale, called by every
+        /// modification of the graph
+        void invalidate_analyses()
+        {
+            epoch++;
+        }
+
+        /// @brief Mark as reachable every block reachable from `from`
+        /// that is not marked yet, `from` included
+        void propagate_reachability(block_id_t from) const;
+
+        /// @brief After removing a reachable block, find which blocks of the
+        /// region reachable from its old sucessors are still reachable
+        /// @param region old sucessors of the removed block
+        void recheck_reachability(const std::vector<BasicBlock *> &region);
+
+        /// @brief Recompute from scratch the blocks reachable from the entry
+        void compute_reachability() const;
+
+        /// @brief Called by a block of the function when its entry flag changes
+        void update_entry_block(bool entry_block)
+        {
+            invalidate_analyses();
+            if (entry_block)
+                entry_count++;
+            else
+                entry_count--;
+            reachability_valid = false;
         }
 
     public:
         ~Function() = default;
 
-        const std::string &get_name() const { return name; }
+        std::string_view get_name() const { return name; }
+
+        /// @brief Get the arena where the blocks of the function are allocated
+        Arena &get_arena() { return *arena; }
+
+        std::uint32_t get_id() const { return id; }
+
+        /// @brief Get the blocks of the function in order of id, which is
+        /// the order they were added in. Deleting a block does not change
+        /// the ids of the others, only compact() renumbers them.
+        SlotRange<block_ptr_t> get_basic_blocks() const { return {basic_blocks, block_count}; }
+
+        /// @brief Get the number of blocks of the function
+        std::size_t get_num_basic_blocks() const { return block_count; }
 
-        const std::vector<std::unique_ptr<BasicBlock>> &get_basic_blocks() const { return basic_blocks; }
+        /// @brief Get the bound of the block ids, the size of a table
+        /// indexed by block id. It is greater than the number of blocks
+        /// while there are slots left empty by deleted blocks.
+        std::size_t get_block_id_bound() const { return basic_blocks.size(); }
 
-        void add_basic_block(std::unique_ptr<BasicBlock> bb)
+        /// @brief Renumber the blocks so the ids are dense again, keeping
+        /// their order, the callback set by set_block_remap_callback is
+        /// told about every block whose id changes. finalize() compacts
+        /// the function first.
+        void compact();
+
+        /// @brief Set the callback told about the ids renumbered by
+        /// compact() and finalize(). Used to keep tables indexed by block id.
+        /// @param callback callback to call, an empty one removes it
+        void set_block_remap_callback(block_remap_t callback) { on_block_remap = std::move(callback); }
+
+        void add_basic_block(block_ptr_t bb)
         {
-            if (!basic_blocks.size())
+            thaw();
+            invalidate_analyses();
+            /// a block created without a parent is adopted, its
+            /// name moves to the arena of the function
+            if (!bb->parent_function)
+                bb->parent_function = this;
+            if (bb->orphan_name)
+            {
+                bb->name = arena->intern(bb->name);
+                bb->orphan_name.reset();
+            }
+            if (!block_count)
                 bb->set_entry_block(true);
+            bb->id = static_cast<block_id_t>(basic_blocks.size());
+            if (bb->get_entry_block())
+            {
+                entry_count++;
+                reachability_valid = false;
+            }
+            reachable.push_back(false);
+            blocks_by_name.emplace(bb->get_name(), bb.get());
+            index_address(bb.get());
             basic_blocks.push_back(std::move(bb));
+            block_count++;
         }
 
+        /// @brief Get the last block added that was not deleted
         BasicBlock *get_last_bb()
         {
             return basic_blocks.back().get();
         }
 
+        /// @brief Check if a block belongs to the function
+        /// @param bb block to check
+        /// @return true if the block is one of the blocks of the function
+        bool contains(const BasicBlock *bb) const
+        {
+            return bb && bb->get_id() < basic_blocks.size() && basic_blocks[bb->get_id()].get() == bb;
+        }
+
+        /// @brief Get a block by its id
+        /// @param id id of the block
+        /// @return block with the given id, nullptr if it does not exist
+        /// or it was deleted
+        BasicBlock *get_basic_block(block_id_t id) const
+        {
+            return id < basic_blocks.size() ? basic_blocks[id].get() : nullptr;
+        }
+
+        /// @brief Get a block by its name, in case of multiple
+        /// blocks with the same name any of them is returned
+        /// @param name name of the block
+        /// @return block with the given name, nullptr if it does not exist
+        BasicBlock *get_basic_block(std::string_view name) const
+        {
+            auto it = blocks_by_name.find(name);
+            return it != blocks_by_name.end() ? it->second : nullptr;
+        }
+
+        /// @brief Get the block whose [start_addr, end_addr) range contains
+        /// the given address. Blocks of a function are not expected to overlap
+        /// @param addr address to look for
+        /// @return block containing the address, nullptr if none does
+        BasicBlock *get_block_by_address(std::uint64_t addr) const
+        {
+            auto last = blocks_by_addr.upper_bound(addr);
+            if (last == blocks_by_addr.begin())
+                return nullptr;
+
+            /// check the blocks with the closest start address
+            for (auto it = blocks_by_addr.lower_bound(std::prev(last)->first); it != last; ++it)
+                if (addr < it->second->get_end_addr())
+                    return it->second;
+
+            return nullptr;
+        }
+
+        /// @brief Delete a block and its edges, the ids of the other
+        /// blocks do not change
+        /// @return true in case there was an error, false other case
         bool delete_basic_block(BasicBlock *bb)
         {
-            auto b = std::find_if(basic_blocks.begin(), basic_blocks.end(), [=](std::unique_ptr<BasicBlock> &b)
-                                  { return b.get() == bb; });
+            CFG_STATS_SCOPE(DeleteBasicBlock);
 
-            if (b == basic_blocks.end())
+            if (!contains(bb))
                 return true;
 
-            delete_block_links(b->get());
-
-            basic_blocks.erase(b);
+            remove_basic_block(bb->get_id());
 
             return false;
         }
 
         bool delete_basic_block(std::string_view name)
         {
-            auto b = std::find_if(basic_blocks.begin(), basic_blocks.end(),
-                                  [=](std::unique_ptr<BasicBlock> &b)
-                                  {
-                                      return b->get_name() == name;
-                                  });
+            CFG_STATS_SCOPE(DeleteBasicBlock);
 
-            if (b == basic_blocks.end())
-                return true;
+            auto bb = get_basic_block(name);
 
-            delete_block_links(b->get());
+            if (bb == nullptr)
+                return true;
 
-            basic_blocks.erase(b);
+            remove_basic_block(bb->get_id());
 
             return false;
         }
 
+        /// @brief Split a block in two at an address. The new block takes
+        /// the range [addr, end_addr), the instructions from `addr` on and
+        /// all the sucessors of `bb`, and `bb` gets a single "fallthrough"
+        /// edge to it. Only the edges of `bb` are rewritten.
+        /// @param bb block to split
+        /// @param addr address of the split, strictly inside the range of `bb`
+        /// @param name name of the new block
+        /// @return the new block, nullptr if the block or address is not valid
+        BasicBlock *split_block(BasicBlock *bb, std::uint64_t addr, std::string_view name = "");
+
+        /// @brief Merge `b` into `a`. `b` must be the only sucessor of `a`,
+        /// `a` the only predecessor of `b`, and `b` not the entry block. `a`
+        /// takes the instructions and the sucessors of `b`, and its range
+        /// is extended when `b` starts where `a` ends. `b` is deleted as
+        /// with delete_basic_block.
+        /// @param a block that is kept
+        /// @param b block merged into `a`
+        /// @return true in case there was an error, false other case
+        bool merge_blocks(BasicBlock *a, BasicBlock *b);
+
+        /// @brief Merge every chain of blocks linked by an edge that is the
+        /// only sucessor of its source and the only predecessor of its target,
+        /// as merge_blocks does, in one sweep over the blocks. Every chain is
+        /// merged into its first block, so cycles of such edges, which cannot
+        /// be reached from the rest of the graph, are left as they are.
+        /// @return number of blocks removed
+        std::size_t collapse_chains();
+
         /// @brief Add a sucessor block
         /// @param src block to include the sucessor
         /// @param dst destination block
@@ -126,102 +627,223 @@ namespace CFG
         /// @return true in case there was an error, false other case
         bool add_sucessor(BasicBlock *src, BasicBlock *dst, std::string_view tag)
         {
-            auto &vec = sucessors[src];
+            CFG_STATS_SCOPE(AddSucessor);
+
+            /// edges are only allowed between blocks of this function
+            if (!contains(src) || !contains(dst))
+                return true;
+
+            thaw();
+
+            auto &vec = src->succ_edges;
+            auto tag_id = arena->intern_tag(tag);
 
             auto it = std::find_if(vec.begin(), vec.end(),
-                                   [=](tag_bb_t tag_bb)
+                                   [=](const succ_edge_t &succ)
                                    {
-                                       return tag_bb.first == tag;
+                                       return succ.tag == tag_id;
                                    });
 
             if (it != vec.end())
                 return true;
 
-            std::string tag_str = tag.data();
+            invalidate_analyses();
 
-            vec.push_back({tag_str, dst});
+            link(src, dst, tag_id);
 
-            predecessor[dst].push_back(src);
+            /// only the region reachable from the new edge is visited
+            if (reachability_valid && reachable[src->get_id()] && !reachable[dst->get_id()])
+                propagate_reachability(dst->get_id());
 
             return false;
         }
 
-        void dump_function_dot(std::ofstream &stream)
+        /// @brief Add many sucessors at once. Every tag is interned once, and
+        /// the edges of sources with few sucessors are checked and added as
+        /// add_sucessor does. The edges of sources with many sucessors, as
+        /// jump tables, are sorted by (source, tag id) to find the duplicates
+        /// in one pass instead of searching the sucessors for every edge, and
+        /// their sucessors are grown once. The sucessors of each source are
+        /// added in the order of the span. As with add_sucessor, edges whose
+        /// source already has an edge with the same tag are not added, and
+        /// neither are edges with blocks of another function.
+        /// @param edges edges to add
+        /// @return true if some edge was not added, false other case
+        bool add_successors(std::span<const Edge> edges);
+
+        /// @brief Add a call from a block to a function of the same module,
+        /// the call between both functions is added to the module too
+        /// @param bb block making the call
+        /// @param callee function called
+        /// @return true in case there was an error or the block already
+        /// calls the function, false other case
+        bool add_call(BasicBlock *bb, Function *callee);
+
+        /// @brief Get the functions called by a block, in the order the
+        /// calls were added
+        const std::vector<Function *> &get_calls(const BasicBlock *bb) const;
+
+        /// @brief Write the function as a DOT digraph, through the buffered
+        /// exporter (see Exporter.hpp)
+        void dump_function_dot(std::ofstream &stream) const;
+
+        /// @brief Check the entry block and the connectivity of the function.
+        /// The number of entry blocks and the reachable blocks are maintained
+        /// by the modifications, so when nothing relevant changed since the
+        /// last call this is constant time.
+        void validate_function() const
         {
-            stream << "digraph \"" << name << "\"{\n";
-            stream << "style=\"dashed\";\n";
-            stream << "color=\"black\";\n";
-            stream << "label=\"" << name << "\";\n";
+            CFG_STATS_SCOPE(ValidateFunction);
 
-            for (auto &node : basic_blocks)
-            {
-                node->dump_block_dot(stream);
-            }
+            if (basic_blocks.size() == 0)
+                throw exceptions::NoEntryBlockException("No entry block found on control flow graph");
 
-            for (auto edge : sucessors)
-            {
-                auto src = edge.first;
+            if (entry_count == 0)
+                throw exceptions::NoEntryBlockException("No entry block found on control flow graph");
+            else if (entry_count > 1)
+                throw exceptions::MultipleEntryBlockException("Multiple entry blocks found on control flow graph");
 
-                auto &vec = edge.second;
+            if (!reachability_valid)
+                compute_reachability();
 
-                for (auto succ : vec)
-                {
-                    auto &tag = succ.first;
-                    auto dst = succ.second;
-                    stream << "\"" << src->get_name() << "\" -> "
-                           << "\"" << dst->get_name() << "\" [style=\"solid,bold\",color=black,weight=10,constraint=true,label=\""
-                           << tag << "\"];\n";
-                }
-            }
+            /// Once we have visited all the nodes following the DFS
+            /// in this kind of graph we should have all the nodes
+            /// visited if they have at least one connection
+            if (block_count != reachable_count)
+                throw exceptions::NoConnectedBlockException("A node in the function is not connected to the control flow graph");
+        }
 
-            stream << "}";
+        /// @brief Depth first search from a block over the block ids, the
+        /// visited blocks are left marked in the context. The search uses
+        /// the memory of the context and does not modify the function.
+        /// @param entry id of the block where the search starts
+        /// @param context scratch memory for the search
+        /// @return number of blocks reachable from `entry`
+        std::size_t count_reachable(block_id_t entry, ReachabilityContext &context) const;
+
+        /// @brief Compact the function and pack its edges in compressed sparse
+        /// row form indexed by block id, with interned tags.
+        /// The function can still be modified afterwards, any modification
+        /// moves the edges back to the mutable representation.
+        void finalize();
+
+        bool is_finalized() const { return finalized; }
+
+        /// @brief Get the mutation epoch of the function, it changes
+        /// every time a block or an edge is added or removed, or the
+        /// entry block changes
+        std::uint64_t get_epoch() const { return epoch; }
+
+        /// @brief Get the result of an analysis of the function, it is
+        /// computed on the first request and kept until the graph is
+        /// modified. The cache is not thread safe.
+        template <typename Analysis>
+        const Analysis &get_analysis() const
+        {
+            return analyses.get<Analysis>(*this, epoch);
         }
 
-        void validate_function()
+        /// @brief Is there an up to date result of an analysis?
+        template <typename Analysis>
+        bool has_analysis() const
         {
-            std::vector<BasicBlock *> todo;
-            std::set<BasicBlock *> visited;
+            return analyses.is_cached<Analysis>(epoch);
+        }
 
-            if (basic_blocks.size() == 0)
-                throw exceptions::NoEntryBlockException("No entry block found on control flow graph");
+        const DominatorTree &get_dominator_tree() const { return get_analysis<DominatorTree>(); }
 
-            auto number_of_entry = std::count_if(basic_blocks.begin(), basic_blocks.end(), [](std::unique_ptr<BasicBlock> &bb)
-                                                 { return bb->get_entry_block(); });
+        const PostDominatorTree &get_post_dominator_tree() const { return get_analysis<PostDominatorTree>(); }
 
-            if (number_of_entry == 0)
-                throw exceptions::NoEntryBlockException("No entry block found on control flow graph");
-            else if (number_of_entry > 1)
-                throw exceptions::MultipleEntryBlockException("Multiple entry blocks found on control flow graph");
+        const LoopInfo &get_loop_info() const { return get_analysis<LoopInfo>(); }
 
-            todo.push_back(basic_blocks[0].get());
+        const BlockSCCs &get_sccs() const { return get_analysis<BlockSCCs>(); }
+
+        /// @brief Get the sucessors of a block, in insertion order
+        BlockRange successors(const BasicBlock *bb) const
+        {
+            if (!contains(bb))
+                return {};
 
-            /// Depth First Search
-            while (!todo.empty())
+            if (finalized)
             {
-                auto node = todo.back();
-                todo.pop_back();
+                auto id = bb->get_id();
+                auto targets = csr.succ_targets.data();
+                return {BlockIterator(targets + csr.succ_begin(id), basic_blocks.data()),
+                        BlockIterator(targets + csr.succ_end(id), basic_blocks.data()), csr.succ_end(id) - csr.succ_begin(id)};
+            }
 
-                if (visited.find(node) != visited.end())
-                    continue;
+            const auto &vec = bb->succ_edges;
+            return {BlockIterator(vec.data()), BlockIterator(vec.data() + vec.size()), vec.size()};
+        }
 
-                visited.insert(node);
+        /// @brief Get the predecessors of a block, one per edge. They are
+        /// ordered by source block once the function is finalized, and in
+        /// no particular order before.
+        BlockRange predecessors(const BasicBlock *bb) const
+        {
+            if (!contains(bb))
+                return {};
 
-                auto suces = sucessors[node];
-                /// visit the nodes in reverse order for the sucessors
-                for (auto suc = suces.rbegin(); suc != suces.rend(); ++suc)
-                    todo.push_back(suc->second);
+            if (finalized)
+            {
+                auto id = bb->get_id();
+                auto sources = csr.pred_sources.data();
+                return {BlockIterator(sources + csr.pred_begin(id), basic_blocks.data()),
+                        BlockIterator(sources + csr.pred_end(id), basic_blocks.data()), csr.pred_end(id) - csr.pred_begin(id)};
             }
 
-            /// Once we have visited all the nodes following the DFS
-            /// in this kind of graph we should have all the nodes
-            /// visited if they have at least one connection
-            if (basic_blocks.size() != visited.size())
-                throw exceptions::NoConnectedBlockException("A node in the function is not connected to the control flow graph");
+            const auto &vec = bb->pred_edges;
+            return {BlockIterator(vec.data()), BlockIterator(vec.data() + vec.size()), vec.size()};
         }
 
-        Function(std::string_view Name, Module *Parent = nullptr) : name(Name), parent_module(Parent) {}
+        /// @brief Get the ids of the blocks reachable from the entry in
+        /// depth first preorder, computed once per version of the graph
+        std::span<const block_id_t> get_preorder() const { return get_analysis<BlockOrder>().get_preorder(); }
+
+        /// @brief Get the ids of the blocks reachable from the entry in postorder
+        std::span<const block_id_t> get_postorder() const { return get_analysis<BlockOrder>().get_postorder(); }
+
+        /// @brief Get the ids of the blocks reachable from the entry in
+        /// reverse postorder, every block before its sucessors except
+        /// for back edges
+        std::span<const block_id_t> get_reverse_postorder() const { return get_analysis<BlockOrder>().get_reverse_postorder(); }
+
+        /// @brief Get the buffer with the instructions of every block
+        const InstructionBuffer &get_instruction_buffer() const { return instructions; }
+
+        /// @brief Rewrite the instruction buffer with the slices of the
+        /// blocks in id order and without dead instructions
+        void compact_instructions();
+
+        /// @brief Write the edges of the function in packed form without
+        /// finalizing it, used by the analyses that work on block ids.
+        /// The slots left by deleted blocks have no edges.
+        /// @param out where to write the edges
+        /// @param dense number the blocks by their position among the
+        /// blocks of the function instead of by id, as compact() would
+        void pack_edges(CSREdges &out, bool dense = false) const;
+
+        /// @brief Get the packed edges of the function
+        /// @return packed edges, only meaningful if the function is finalized
+        const CSREdges &get_csr() const { return csr; }
+
+        /// @brief Get the bytes taken by the edges out of the blocks: the
+        /// lists that did not fit inline and the packed edges
+        std::size_t get_edge_bytes() const;
+
+        Function(std::string_view Name, Module *Parent = nullptr);
+
+        /// @brief Function of a module whose blocks and names are allocated
+        /// in the given arena instead of the one of the module, used to build
+        /// functions concurrently (see ModuleBuilder)
+        Function(std::string_view Name, Module *Parent, Arena &Storage);
 
     public:
+        /// @brief Static function to create a new function, the function
+        /// is allocated in the arena of the parent module
+        /// @param Name name given to the function
+        /// @param Parent parent module of the function
+        /// @return pointer to a new allocated function
         static Function *Create(std::string_view Name, Module *Parent = nullptr);
 
         friend std::ostream &operator<<(std::ostream &os, const Function &func)
@@ -232,6 +854,19 @@ namespace CFG
             return os;
         }
     };
+
+    inline BasicBlock *Function::BlockIterator::operator*() const
+    {
+        switch (kind)
+        {
+        case kind_t::Sucessors:
+            return succ->target;
+        case kind_t::Predecessors:
+            return pred->source;
+        default:
+            return blocks[*packed].get();
+        }
+    }
 } // namespace CFG
 
 #endif
\ No newline at end of file
@@ -0,0 +1,75 @@
+//--------------------------------------------------------------------*- C++ -*-
+// CFG: example of CFG
+//
+// @file Generator.hpp
+// @brief Seeded generator of synthetic control flow graphs
+
+#ifndef GENERATOR_HPP
+#define GENERATOR_HPP
+
+#include "cfg/Module.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace CFG
+{
+    /// @brief Kinds of graphs of the generator. In every kind block 0 is
+    /// the entry and every block is reachable from it.
+    enum class GraphShape
+    {
+        /// @brief chain of blocks with random forward jumps
+        RandomDag,
+        /// @brief chain of blocks with many short and nested back edges
+        Loops,
+        /// @brief jump tables with wide fan-out joining again afterwards
+        Switch,
+        /// @brief sequence of the constructs a compiler emits: straight
+        /// code, if-then, if-then-else, loops and small switches
+        Compiler,
+    };
+
+    /// @brief Get the name of a shape, for reports
+    std::string_view shape_name(GraphShape shape);
+
+    /// @brief Edge of a generated graph, `tag` indexes GeneratedGraph::tags
+    struct GeneratedEdge
+    {
+        block_id_t src;
+        block_id_t dst;
+        std::uint32_t tag;
+    };
+
+    /// @brief Graph produced by the generator, independent of any Function
+    /// so the same graph can be built many times. The tags of the edges
+    /// leaving a block are all different.
+    struct GeneratedGraph
+    {
+        std::size_t num_blocks{0};
+        std::vector<GeneratedEdge> edges;
+        std::vector<std::string> tags;
+
+        std::string_view get_tag(const GeneratedEdge &edge) const { return tags[edge.tag]; }
+    };
+
+    /// @brief Generate a graph, the same shape, size and seed always
+    /// give the same graph
+    /// @param shape kind of graph
+    /// @param num_blocks number of blocks, at least 1
+    /// @param seed seed of the random generator
+    GeneratedGraph generate_graph(GraphShape shape, std::size_t num_blocks, std::uint64_t seed);
+
+    /// @brief Create a function with a generated graph. Block i is named
+    /// "bb<i>" and covers [0x1000 + 16 * i, 0x1000 + 16 * (i + 1)), the
+    /// edges are added in one batch.
+    /// @param G graph to build
+    /// @param M module of the new function
+    /// @param name name of the new function
+    /// @return the new function
+    Function *build_function(const GeneratedGraph &G, Module *M, std::string_view name);
+} // namespace CFG
+
+#endif
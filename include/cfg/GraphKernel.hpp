@@ -0,0 +1,454 @@
+//--------------------------------------------------------------------*- C++ -*-
+// CFG: example of CFG
+//
+// @file GraphKernel.hpp
+// @brief Compact graphs specialized at compile time by a storage policy,
+// and the traversal kernels shared by every graph representation
+
+#ifndef GRAPHKERNEL_HPP
+#define GRAPHKERNEL_HPP
+
+#include "cfg/Function.hpp"
+
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace CFG
+{
+    /// @brief Tag type of the graphs whose edges have no tag
+    struct NoTag
+    {
+        friend bool operator==(NoTag, NoTag) = default;
+    };
+
+    /// @brief Tags of the usual branches, for graphs that only need to
+    /// tell apart the kind of each edge
+    enum class BranchTag : std::uint8_t
+    {
+        Fallthrough,
+        True,
+        False,
+        Jump,
+        Loop,
+        Other,
+    };
+
+    /// @brief Get the branch kind of a tag, the empty tag is a fallthrough
+    /// and the tags not known are `Other`
+    inline BranchTag branch_tag(std::string_view tag)
+    {
+        if (tag.empty() || tag == "fallthrough")
+            return BranchTag::Fallthrough;
+        if (tag == "true")
+            return BranchTag::True;
+        if (tag == "false")
+            return BranchTag::False;
+        if (tag == "jump")
+            return BranchTag::Jump;
+        if (tag == "loop")
+            return BranchTag::Loop;
+        return BranchTag::Other;
+    }
+
+    /// @brief Maximum number of sucessors of a policy with no limit
+    inline constexpr std::size_t dynamic_arity = 0;
+
+    /// @brief Storage policy of a BasicGraph
+    /// @tparam Index unsigned type of the node indices and edge offsets
+    /// @tparam Tag type of the edge tags: NoTag, BranchTag, tag_id_t for
+    /// the interned tags of the function, or any other type given a
+    /// conversion when the graph is built
+    /// @tparam MaxSuccessors sucessors stored inline in each node, or
+    /// dynamic_arity to keep them in a packed array of any length
+    template <typename Index, typename Tag = NoTag, std::size_t MaxSuccessors = dynamic_arity>
+    struct GraphPolicy
+    {
+        static_assert(std::is_unsigned_v<Index>, "node indices must be unsigned");
+        static_assert(MaxSuccessors <= std::numeric_limits<std::uint8_t>::max(), "too many inline sucessors");
+
+        using index_t = Index;
+        using tag_t = Tag;
+
+        static constexpr std::size_t max_successors = MaxSuccessors;
+        static constexpr bool fixed_arity = MaxSuccessors != dynamic_arity;
+        static constexpr bool tagged = !std::is_same_v<Tag, NoTag>;
+    };
+
+    /// @brief Same layout as the packed edges of a finalized function
+    using DefaultGraphPolicy = GraphPolicy<block_id_t, tag_id_t>;
+    /// @brief Two-way branches without tags, as in most compiled code
+    using BranchGraphPolicy = GraphPolicy<std::uint32_t, NoTag, 2>;
+    /// @brief Two-way branches that keep the kind of each edge
+    using TaggedBranchGraphPolicy = GraphPolicy<std::uint32_t, BranchTag, 2>;
+    /// @brief Graphs with more than 4G blocks or edges
+    using WideGraphPolicy = GraphPolicy<std::uint64_t>;
+
+    /// @brief Graph the traversal kernels work on: dense node indices in
+    /// [0, size()) and the sucessors and predecessors of a node as spans
+    template <typename G>
+    concept TraversableGraph = requires(const G &g, typename G::index_t n) {
+        typename G::index_t;
+        { g.size() } -> std::convertible_to<std::size_t>;
+        { g.successors(n) } -> std::convertible_to<std::span<const typename G::index_t>>;
+        { g.predecessors(n) } -> std::convertible_to<std::span<const typename G::index_t>>;
+    };
+
+    /// @brief Packed edges of a function seen as a TraversableGraph,
+    /// the default representation of the analyses
+    class CSRGraphView
+    {
+        const CSREdges *edges;
+
+    public:
+        using index_t = block_id_t;
+
+        explicit CSRGraphView(const CSREdges &edges) : edges(&edges) {}
+
+        std::size_t size() const { return edges->num_blocks(); }
+
+        std::span<const index_t> successors(index_t n) const
+        {
+            return {edges->succ_targets.data() + edges->succ_begin(n), edges->succ_end(n) - edges->succ_begin(n)};
+        }
+
+        std::span<const index_t> predecessors(index_t n) const
+        {
+            return {edges->pred_sources.data() + edges->pred_begin(n), edges->pred_end(n) - edges->pred_begin(n)};
+        }
+    };
+
+    /// @brief Immutable snapshot of the graph of a function, laid out as the
+    /// policy says. With a fixed arity the sucessors of each node are stored
+    /// inline, so reading them takes no indirection, and an untagged graph
+    /// stores no tags at all. The predecessors are always packed.
+    ///
+    /// Node i is the block with id i, the ids of deleted blocks are nodes
+    /// without edges. The graph does not follow later changes of the function.
+    template <typename Policy>
+    class BasicGraph
+    {
+    public:
+        using policy_t = Policy;
+        using index_t = typename Policy::index_t;
+        using tag_t = typename Policy::tag_t;
+
+        static constexpr std::size_t max_successors = Policy::max_successors;
+        static constexpr bool fixed_arity = Policy::fixed_arity;
+        static constexpr bool tagged = Policy::tagged;
+
+        /// @brief index of the missing nodes
+        static constexpr index_t none = std::numeric_limits<index_t>::max();
+
+    private:
+        /// @brief member types of the parts a policy does not use
+        struct Unused
+        {
+            void clear() {}
+        };
+
+        using slots_t = std::array<index_t, fixed_arity ? max_successors : 1>;
+        using tag_slots_t = std::array<tag_t, fixed_arity ? max_successors : 1>;
+
+        using succ_offsets_t = std::conditional_t<fixed_arity, std::vector<std::uint8_t>, std::vector<index_t>>;
+        using succ_targets_t = std::conditional_t<fixed_arity, std::vector<slots_t>, std::vector<index_t>>;
+        using succ_tags_t = std::conditional_t<!tagged, Unused,
+                                               std::conditional_t<fixed_arity, std::vector<tag_slots_t>, std::vector<tag_t>>>;
+        using tag_names_t = std::conditional_t<std::is_same_v<tag_t, tag_id_t>, TagTable, Unused>;
+
+        /// @brief with a fixed arity the number of sucessors of each node,
+        /// else the offsets of the packed sucessors, one per node plus one
+        succ_offsets_t succ_offsets;
+        /// @brief the inline sucessors of each node or the packed ones
+        succ_targets_t succ_targets;
+        [[no_unique_address]] succ_tags_t succ_tags;
+        /// @brief names of the tags when they are the interned ids
+        [[no_unique_address]] tag_names_t tag_names;
+        std::vector<index_t> pred_offsets;
+        std::vector<index_t> pred_sources;
+        std::size_t edges{0};
+        index_t entry{none};
+
+        /// @brief conversion of the tags the graph knows by itself
+        static tag_t default_tag(tag_id_t id, std::string_view tag)
+        {
+            if constexpr (std::is_same_v<tag_t, NoTag>)
+                return {};
+            else if constexpr (std::is_same_v<tag_t, BranchTag>)
+                return branch_tag(tag);
+            else if constexpr (std::is_same_v<tag_t, tag_id_t>)
+                return id;
+            else
+                static_assert(!sizeof(tag_t), "a conversion of the tags must be given for this tag type");
+        }
+
+    public:
+        BasicGraph() = default;
+
+        /// @brief Build the graph of a function with the default
+        /// conversion of the tags
+        /// @return true in case there was an error, false other case
+        bool assign(const Function &F)
+        {
+            return assign(F, &default_tag);
+        }
+
+        /// @brief Build the graph of a function. It fails if a block has more
+        /// sucessors than the policy stores inline or if the blocks or edges
+        /// do not fit in the index type; the graph is left empty then.
+        /// @param F function to copy
+        /// @param convert callable (tag_id_t, std::string_view) -> tag_t
+        /// @return true in case there was an error, false other case
+        template <typename Convert>
+        bool assign(const Function &F, Convert &&convert)
+        {
+            clear();
+
+            CSREdges local;
+            const CSREdges *csr = &F.get_csr();
+            if (!F.is_finalized())
+            {
+                F.pack_edges(local);
+                csr = &local;
+            }
+
+            const std::size_t n = F.get_block_id_bound();
+            if (n >= none || csr->num_edges() >= none)
+                return true;
+
+            if constexpr (fixed_arity)
+            {
+                for (block_id_t id = 0; id < n; id++)
+                    if (csr->succ_end(id) - csr->succ_begin(id) > max_successors)
+                        return true;
+
+                succ_offsets.resize(n);
+                succ_targets.resize(n);
+                if constexpr (tagged)
+                    succ_tags.resize(n);
+
+                for (block_id_t id = 0; id < n; id++)
+                {
+                    auto &slots = succ_targets[id];
+                    slots.fill(none);
+                    std::uint8_t degree = 0;
+                    for (auto e = csr->succ_begin(id); e < csr->succ_end(id); e++, degree++)
+                    {
+                        slots[degree] = static_cast<index_t>(csr->succ_targets[e]);
+                        if constexpr (tagged)
+                            succ_tags[id][degree] = convert(csr->succ_tags[e], csr->tags.get(csr->succ_tags[e]));
+                    }
+                    succ_offsets[id] = degree;
+                }
+            }
+            else
+            {
+                succ_offsets.assign(csr->succ_offsets.begin(), csr->succ_offsets.end());
+                succ_targets.assign(csr->succ_targets.begin(), csr->succ_targets.end());
+                if constexpr (tagged)
+                {
+                    succ_tags.reserve(csr->num_edges());
+                    for (auto tag : csr->succ_tags)
+                        succ_tags.push_back(convert(tag, csr->tags.get(tag)));
+                }
+            }
+
+            if constexpr (std::is_same_v<tag_t, tag_id_t>)
+                tag_names = csr->tags;
+
+            pred_offsets.assign(csr->pred_offsets.begin(), csr->pred_offsets.end());
+            pred_sources.assign(csr->pred_sources.begin(), csr->pred_sources.end());
+            edges = csr->num_edges();
+
+            for (block_id_t id = 0; id < n; id++)
+                if (auto bb = F.get_basic_block(id); bb && bb->get_entry_block())
+                {
+                    entry = static_cast<index_t>(id);
+                    break;
+                }
+
+            return false;
+        }
+
+        void clear()
+        {
+            succ_offsets.clear();
+            succ_targets.clear();
+            succ_tags.clear();
+            tag_names.clear();
+            pred_offsets.clear();
+            pred_sources.clear();
+            edges = 0;
+            entry = none;
+        }
+
+        /// @brief Get the number of nodes
+        std::size_t size() const { return pred_offsets.empty() ? 0 : pred_offsets.size() - 1; }
+
+        std::size_t num_edges() const { return edges; }
+
+        /// @brief Get the node of the entry block, none if there is no entry
+        index_t get_entry() const { return entry; }
+
+        std::span<const index_t> successors(index_t n) const
+        {
+            if constexpr (fixed_arity)
+                return {succ_targets[n].data(), succ_offsets[n]};
+            else
+                return {succ_targets.data() + succ_offsets[n], std::size_t(succ_offsets[n + 1] - succ_offsets[n])};
+        }
+
+        /// @brief Get the tags of the sucessors of a node, in the same order
+        std::span<const tag_t> successor_tags(index_t n) const
+            requires tagged
+        {
+            if constexpr (fixed_arity)
+                return {succ_tags[n].data(), succ_offsets[n]};
+            else
+                return {succ_tags.data() + succ_offsets[n], std::size_t(succ_offsets[n + 1] - succ_offsets[n])};
+        }
+
+        /// @brief Get the name of an interned tag
+        std::string_view get_tag_name(tag_id_t id) const
+            requires std::is_same_v<tag_t, tag_id_t>
+        {
+            return tag_names.get(id);
+        }
+
+        std::span<const index_t> predecessors(index_t n) const
+        {
+            return {pred_sources.data() + pred_offsets[n], std::size_t(pred_offsets[n + 1] - pred_offsets[n])};
+        }
+    };
+
+    /// @brief Graph with the default policy, the packed form of the
+    /// graph of a function
+    using Graph = BasicGraph<DefaultGraphPolicy>;
+
+    /// @brief Depth first search from a node, the sucessors of each node
+    /// are visited in order
+    /// @param G graph to search
+    /// @param root node where the search starts
+    /// @param preorder if not null, receives the nodes in preorder
+    /// @param postorder if not null, receives the nodes in postorder
+    /// @param visited marks of the nodes, the search skips the marked nodes
+    /// and marks the ones it visits, so it can be reused across searches
+    template <TraversableGraph G>
+    void depth_first_search(const G &g, typename G::index_t root, std::vector<typename G::index_t> *preorder,
+                            std::vector<typename G::index_t> *postorder, std::vector<bool> &visited)
+    {
+        using index_t = typename G::index_t;
+
+        if (visited[root])
+            return;
+
+        struct Frame
+        {
+            const index_t *next;
+            const index_t *end;
+            index_t node;
+        };
+        std::vector<Frame> stack;
+
+        auto visit = [&](index_t node)
+        {
+            visited[node] = true;
+            if (preorder)
+                preorder->push_back(node);
+            auto succs = g.successors(node);
+            stack.push_back({succs.data(), succs.data() + succs.size(), node});
+        };
+
+        visit(root);
+        while (!stack.empty())
+        {
+            auto &top = stack.back();
+            if (top.next != top.end)
+            {
+                auto next = *top.next++;
+                if (!visited[next])
+                    visit(next);
+                continue;
+            }
+
+            if (postorder)
+                postorder->push_back(top.node);
+            stack.pop_back();
+        }
+    }
+
+    /// @brief Get the nodes reachable from `root` in reverse postorder
+    template <TraversableGraph G>
+    std::vector<typename G::index_t> reverse_postorder(const G &g, typename G::index_t root)
+    {
+        std::vector<typename G::index_t> order;
+        std::vector<bool> visited(g.size());
+        depth_first_search(g, root, nullptr, &order, visited);
+        std::reverse(order.begin(), order.end());
+        return order;
+    }
+
+    /// @brief Immediate dominators of the nodes reachable from `root`, with
+    /// the iterative method of Cooper, Harvey and Kennedy over the reverse
+    /// postorder. It is simpler than the Lengauer-Tarjan algorithm of
+    /// DominatorTree and as fast on graphs of low depth.
+    /// @return immediate dominator of each node, max index for the root
+    /// and the nodes not reachable
+    template <TraversableGraph G>
+    std::vector<typename G::index_t> immediate_dominators(const G &g, typename G::index_t root)
+    {
+        using index_t = typename G::index_t;
+        constexpr index_t missing = std::numeric_limits<index_t>::max();
+
+        auto order = reverse_postorder(g, root);
+        std::vector<index_t> position(g.size(), missing);
+        for (std::size_t i = 0; i < order.size(); i++)
+            position[order[i]] = static_cast<index_t>(i);
+
+        std::vector<index_t> idom(g.size(), missing);
+        idom[root] = root;
+
+        auto intersect = [&](index_t a, index_t b)
+        {
+            while (a != b)
+            {
+                while (position[a] > position[b])
+                    a = idom[a];
+                while (position[b] > position[a])
+                    b = idom[b];
+            }
+            return a;
+        };
+
+        for (bool changed = true; changed;)
+        {
+            changed = false;
+            for (std::size_t i = 1; i < order.size(); i++)
+            {
+                auto node = order[i];
+                auto dom = missing;
+                for (auto pred : g.predecessors(node))
+                    if (idom[pred] != missing)
+                        dom = dom == missing ? pred : intersect(pred, dom);
+
+                if (idom[node] != dom)
+                {
+                    idom[node] = dom;
+                    changed = true;
+                }
+            }
+        }
+
+        idom[root] = missing;
+        return idom;
+    }
+} // namespace CFG
+
+#endif
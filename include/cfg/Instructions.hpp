@@ -0,0 +1,169 @@
+//--------------------------------------------------------------------*- C++ -*-
+// CFG: example of CFG
+//
+// @file Instructions.hpp
+// @brief Instructions of a function stored as structure of arrays
+
+#ifndef INSTRUCTIONS_HPP
+#define INSTRUCTIONS_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace CFG
+{
+    using opcode_t = std::uint16_t;
+    using operand_t = std::uint64_t;
+
+    /// @brief Instructions of all the blocks of a function in one buffer,
+    /// each field in its own array so a scan over the opcodes or the
+    /// addresses of a block reads contiguous memory. Every block owns a
+    /// contiguous slice [begin, end) of the buffer; the operands of
+    /// instruction i are operands[operand_offsets[i], operand_offsets[i + 1]).
+    class InstructionBuffer
+    {
+        std::vector<opcode_t> opcodes;
+        std::vector<std::uint64_t> addresses;
+        std::vector<std::uint32_t> operand_offsets{0};
+        std::vector<operand_t> operands;
+
+    public:
+        std::uint32_t size() const { return static_cast<std::uint32_t>(opcodes.size()); }
+
+        /// @brief Get the bytes reserved by the arrays of the buffer
+        std::size_t get_bytes() const
+        {
+            return opcodes.capacity() * sizeof(opcode_t) + addresses.capacity() * sizeof(std::uint64_t) +
+                   operand_offsets.capacity() * sizeof(std::uint32_t) + operands.capacity() * sizeof(operand_t);
+        }
+
+        opcode_t get_opcode(std::uint32_t i) const { return opcodes[i]; }
+
+        std::uint64_t get_address(std::uint32_t i) const { return addresses[i]; }
+
+        std::span<const operand_t> get_operands(std::uint32_t i) const
+        {
+            return {operands.data() + operand_offsets[i], operands.data() + operand_offsets[i + 1]};
+        }
+
+        std::span<const opcode_t> get_opcodes(std::uint32_t begin, std::uint32_t end) const
+        {
+            return {opcodes.data() + begin, opcodes.data() + end};
+        }
+
+        std::span<const std::uint64_t> get_addresses(std::uint32_t begin, std::uint32_t end) const
+        {
+            return {addresses.data() + begin, addresses.data() + end};
+        }
+
+        /// @brief Add an instruction at the end of the buffer
+        /// @return index of the instruction
+        std::uint32_t append(opcode_t opcode, std::uint64_t address, std::span<const operand_t> ops)
+        {
+            opcodes.push_back(opcode);
+            addresses.push_back(address);
+            operands.insert(operands.end(), ops.begin(), ops.end());
+            operand_offsets.push_back(static_cast<std::uint32_t>(operands.size()));
+            return size() - 1;
+        }
+
+        /// @brief Copy the instructions [begin, end) of another buffer, or
+        /// of this one, at the end of the buffer
+        /// @return index of the first copied instruction
+        std::uint32_t append(const InstructionBuffer &from, std::uint32_t begin, std::uint32_t end)
+        {
+            auto first = size();
+            auto op_begin = from.operand_offsets[begin], op_end = from.operand_offsets[end];
+
+            /// reserve first, the source may be this same buffer
+            opcodes.reserve(opcodes.size() + (end - begin));
+            addresses.reserve(addresses.size() + (end - begin));
+            operand_offsets.reserve(operand_offsets.size() + (end - begin));
+            operands.reserve(operands.size() + (op_end - op_begin));
+
+            for (auto i = begin; i < end; i++)
+            {
+                opcodes.push_back(from.opcodes[i]);
+                addresses.push_back(from.addresses[i]);
+            }
+            for (auto o = op_begin; o < op_end; o++)
+                operands.push_back(from.operands[o]);
+            for (auto i = begin; i < end; i++)
+                operand_offsets.push_back(operand_offsets.back() + (from.operand_offsets[i + 1] - from.operand_offsets[i]));
+
+            return first;
+        }
+
+        /// @brief Find the first instruction of a slice whose address is not
+        /// lower than `address`, the instructions of the slice must be in
+        /// increasing address order
+        /// @return index of the instruction, `end` if there is none
+        std::uint32_t lower_bound(std::uint32_t begin, std::uint32_t end, std::uint64_t address) const
+        {
+            auto it = std::lower_bound(addresses.begin() + begin, addresses.begin() + end, address);
+            return static_cast<std::uint32_t>(it - addresses.begin());
+        }
+
+        void clear()
+        {
+            opcodes.clear();
+            addresses.clear();
+            operand_offsets.assign(1, 0);
+            operands.clear();
+        }
+
+        void swap(InstructionBuffer &other)
+        {
+            opcodes.swap(other.opcodes);
+            addresses.swap(other.addresses);
+            operand_offsets.swap(other.operand_offsets);
+            operands.swap(other.operands);
+        }
+    };
+
+    /// @brief View of an instruction of a buffer
+    struct Instruction
+    {
+        opcode_t opcode;
+        std::uint64_t address;
+        std::span<const operand_t> operands;
+    };
+
+    /// @brief Slice of a buffer with the instructions of a block
+    class InstructionSlice
+    {
+        const InstructionBuffer *buffer;
+        std::uint32_t begin_index;
+        std::uint32_t end_index;
+
+    public:
+        InstructionSlice(const InstructionBuffer *buffer, std::uint32_t begin, std::uint32_t end)
+            : buffer(buffer), begin_index(begin), end_index(end) {}
+
+        std::uint32_t size() const { return end_index - begin_index; }
+
+        bool empty() const { return begin_index == end_index; }
+
+        /// @brief index of the first instruction in the buffer
+        std::uint32_t get_begin() const { return begin_index; }
+
+        std::uint32_t get_end() const { return end_index; }
+
+        Instruction operator[](std::uint32_t i) const
+        {
+            auto index = begin_index + i;
+            return {buffer->get_opcode(index), buffer->get_address(index), buffer->get_operands(index)};
+        }
+
+        /// @brief Opcodes of the slice as contiguous memory
+        std::span<const opcode_t> opcodes() const { return buffer->get_opcodes(begin_index, end_index); }
+
+        /// @brief Addresses of the slice as contiguous memory
+        std::span<const std::uint64_t> addresses() const { return buffer->get_addresses(begin_index, end_index); }
+    };
+} // namespace CFG
+
+#endif
@@ -0,0 +1,99 @@
+//--------------------------------------------------------------------*- C++ -*-
+// CFG: example of CFG
+//
+// @file LoopInfo.hpp
+// @brief Loop nesting forest of a Function
+
+#ifndef LOOPINFO_HPP
+#define LOOPINFO_HPP
+
+#include "cfg/BasicBlock.hpp"
+
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace CFG
+{
+    class Function;
+
+    /// @brief Loops of a function organized as a nesting forest, computed
+    /// with the algorithm of Havlak: union-find over the depth first
+    /// preorder, near linear for reducible graphs. The entries into an
+    /// irreducible region are moved to its header once per entry block,
+    /// but nested irreducible regions can still take quadratic time.
+    /// Reducible loops are natural loops identified by their header,
+    /// irreducible regions are reported as loops headed by the first
+    /// block of the region reached by the depth first search.
+    class LoopInfo
+    {
+    public:
+        /// @brief id used for a missing loop
+        static constexpr std::uint32_t no_loop = std::numeric_limits<std::uint32_t>::max();
+
+        /// @brief A loop of the function
+        struct Loop
+        {
+            /// @brief header of the loop
+            block_id_t header;
+            /// @brief enclosing loop, no_loop for the outermost loops
+            std::uint32_t parent;
+            /// @brief nesting depth, 1 for the outermost loops
+            std::uint32_t depth;
+            /// @brief is the loop an irreducible region (multiple entries)?
+            bool irreducible;
+            /// @brief blocks whose innermost loop is this one, header included
+            std::vector<block_id_t> blocks;
+            /// @brief loops nested directly inside this one
+            std::vector<std::uint32_t> children;
+        };
+
+    private:
+        /// @brief all the loops, a loop always comes after its parent
+        std::vector<Loop> loops;
+        /// @brief innermost loop of each block
+        std::vector<std::uint32_t> block_loop;
+        /// @brief edges that go back to a block of the current depth first
+        /// search path, as (source, destination) pairs
+        std::vector<std::pair<block_id_t, block_id_t>> back_edges;
+
+    public:
+        /// @brief Compute the loops of a function
+        /// @param F function to analyze
+        explicit LoopInfo(const Function &F);
+
+        const std::vector<Loop> &get_loops() const { return loops; }
+
+        const std::vector<std::pair<block_id_t, block_id_t>> &get_back_edges() const { return back_edges; }
+
+        /// @brief Get the innermost loop that contains a block
+        /// @return index of the loop, no_loop if the block is not in a loop
+        std::uint32_t get_loop_for(block_id_t id) const { return block_loop[id]; }
+
+        /// @brief Get the number of loops that contain a block
+        std::uint32_t get_loop_depth(block_id_t id) const
+        {
+            return block_loop[id] == no_loop ? 0 : loops[block_loop[id]].depth;
+        }
+
+        std::uint32_t get_loop_depth(const BasicBlock *bb) const { return get_loop_depth(bb->get_id()); }
+
+        /// @brief Is the block the header of a loop?
+        bool is_loop_header(block_id_t id) const
+        {
+            return block_loop[id] != no_loop && loops[block_loop[id]].header == id;
+        }
+
+        /// @brief Does the loop contain the block, directly or in a nested loop?
+        bool contains(std::uint32_t loop, block_id_t id) const
+        {
+            for (auto l = block_loop[id]; l != no_loop; l = loops[l].parent)
+                if (l == loop)
+                    return true;
+            return false;
+        }
+    };
+} // namespace CFG
+
+#endif
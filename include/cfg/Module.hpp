@@ -8,19 +8,107 @@
 #define MODULE_HPP
 
 #include "cfg/Function.hpp"
+#include "cfg/SlotRange.hpp"
+#include "cfg/ValidationReport.hpp"
 #include <iostream>
 #include <vector>
 #include <memory>
 #include <algorithm>
+#include <unordered_map>
+#include <functional>
 
 namespace CFG
 {
     class Module
     {
+    public:
+        /// @brief Owning pointer to a function, functions live in the arena
+        using function_ptr_t = arena_ptr<Function>;
+
+        /// @brief Callback called by compact() for every function that
+        /// changes its id, as with the blocks of a function
+        /// (see Function::block_remap_t)
+        using function_remap_t = std::function<void(std::uint32_t old_id, std::uint32_t new_id)>;
+
+    private:
+        /// @brief Arena with the functions, blocks and names of the module,
+        /// declared first so it is released after all of them are destroyed
+        Arena arena;
+        /// @brief Arenas of the functions built concurrently (see
+        /// ModuleBuilder), released after the functions too
+        std::vector<std::unique_ptr<Arena>> adopted_arenas;
         /// @brief Name of the module
         std::string name;
-        /// @brief Vector with functions
-        std::vector<std::unique_ptr<Function>> functions;
+        /// @brief Functions indexed by id, a deleted function leaves
+        /// its slot empty until the module is compacted
+        std::vector<function_ptr_t> functions;
+        /// @brief number of functions in `functions`, the empty slots excluded
+        std::size_t function_count{0};
+        /// @brief functions indexed by name
+        std::unordered_multimap<std::string_view, Function *> functions_by_name;
+
+        /// @brief functions called by each function
+        std::unordered_map<Function *, std::vector<Function *>> callees;
+        /// @brief functions calling each function
+        std::unordered_map<Function *, std::vector<Function *>> callers;
+
+        /// @brief called by compact() for every renumbered function
+        function_remap_t on_function_remap;
+
+        friend class ModuleBuilder;
+
+        /// @brief Keep an arena with functions of the module
+        void adopt_arena(std::unique_ptr<Arena> other)
+        {
+            adopted_arenas.push_back(std::move(other));
+        }
+
+        void delete_call_links(Function *func)
+        {
+            for (auto caller : callers[func])
+            {
+                auto &vec = callees[caller];
+                vec.erase(std::remove(vec.begin(), vec.end(), func), vec.end());
+                caller->drop_calls_to(func);
+            }
+
+            for (auto callee : callees[func])
+            {
+                auto &vec = callers[callee];
+                vec.erase(std::remove(vec.begin(), vec.end(), func), vec.end());
+            }
+
+            callers.erase(func);
+            callees.erase(func);
+        }
+
+        /// @brief Remove the function with the given id. Its slot is left
+        /// empty so the ids and the order of the other functions do not
+        /// change, the empty slots at the end are dropped right away and
+        /// the rest are reclaimed by compact()
+        /// @param id id of the function to remove
+        void remove_function(std::uint32_t id)
+        {
+            auto func = functions[id].get();
+
+            auto range = functions_by_name.equal_range(func->get_name());
+            for (auto it = range.first; it != range.second; ++it)
+            {
+                if (it->second == func)
+                {
+                    functions_by_name.erase(it);
+                    break;
+                }
+            }
+
+            delete_call_links(func);
+
+            functions[id].reset();
+            function_count--;
+
+            while (!functions.empty() && !functions.back())
+                functions.pop_back();
+        }
 
     public:
         ~Module()
@@ -31,45 +119,168 @@ namespace CFG
 
         const std::string &get_name() const { return name; }
 
-        const std::vector<std::unique_ptr<Function>> &get_functions() const
+        /// @brief Get the arena where functions, blocks and names are allocated,
+        /// the functions built by a ModuleBuilder use the arenas of its workers
+        Arena &get_arena() { return arena; }
+
+        /// @brief Get the bytes reserved by the arena of the module and
+        /// the arenas it adopted
+        std::size_t get_arena_bytes() const
         {
-            return functions;
+            auto bytes = arena.get_bytes_reserved();
+            for (const auto &adopted : adopted_arenas)
+                bytes += adopted->get_bytes_reserved();
+            return bytes;
         }
 
-        bool delete_function(Function *func)
+        /// @brief Get the functions of the module in order of id, which is
+        /// the order they were added in. Deleting a function does not change
+        /// the ids of the others, only compact() renumbers them.
+        SlotRange<function_ptr_t> get_functions() const
+        {
+            return {functions, function_count};
+        }
+
+        /// @brief Get the number of functions of the module
+        std::size_t get_num_functions() const { return function_count; }
+
+        /// @brief Get the bound of the function ids, the size of a table
+        /// indexed by function id
+        std::size_t get_function_id_bound() const { return functions.size(); }
+
+        /// @brief Renumber the functions so the ids are dense again, keeping
+        /// their order, the callback set by set_function_remap_callback is
+        /// told about every function whose id changes
+        void compact();
+
+        /// @brief Set the callback told about the ids renumbered by
+        /// compact(), used to keep tables indexed by function id
+        /// @param callback callback to call, an empty one removes it
+        void set_function_remap_callback(function_remap_t callback) { on_function_remap = std::move(callback); }
+
+        /// @brief Check if a function belongs to the module
+        /// @param func function to check
+        /// @return true if the function is one of the functions of the module
+        bool contains(const Function *func) const
+        {
+            return func && func->get_id() < functions.size() && functions[func->get_id()].get() == func;
+        }
+
+        /// @brief Get a function by its id
+        /// @param id id of the function
+        /// @return function with the given id, nullptr if it does not exist
+        /// or it was deleted
+        Function *get_function(std::uint32_t id) const
+        {
+            return id < functions.size() ? functions[id].get() : nullptr;
+        }
+
+        /// @brief Get a function by its name, in case of multiple
+        /// functions with the same name any of them is returned
+        /// @param name name of the function
+        /// @return function with the given name, nullptr if it does not exist
+        Function *get_function(std::string_view name) const
         {
-            auto f = std::find_if(functions.begin(), functions.end(), [=](std::unique_ptr<Function> &f)
-                                  { return f.get() == func; });
+            auto it = functions_by_name.find(name);
+            return it != functions_by_name.end() ? it->second : nullptr;
+        }
 
-            if (f == functions.end())
+        /// @brief Delete a function, the ids of the other functions
+        /// do not change
+        /// @return true in case there was an error, false other case
+        bool delete_function(Function *func)
+        {
+            if (!contains(func))
                 return true;
 
-            functions.erase(f);
+            remove_function(func->get_id());
 
             return false;
         }
 
         bool delete_function(std::string_view name)
         {
-            auto f = std::find_if(functions.begin(), functions.end(),
-                                  [=](std::unique_ptr<Function> &f)
-                                  {
-                                      return f->get_name() == name;
-                                  });
+            auto func = get_function(name);
 
-            if (f == functions.end())
+            if (func == nullptr)
                 return true;
 
-            functions.erase(f);
+            remove_function(func->get_id());
 
             return false;
         }
 
-        void add_function(std::unique_ptr<Function> func)
+        void add_function(function_ptr_t func)
         {
+            func->id = static_cast<std::uint32_t>(functions.size());
+            functions_by_name.emplace(func->get_name(), func.get());
             functions.push_back(std::move(func));
+            function_count++;
+        }
+
+        /// @brief Add a call from a function to another, recursive calls
+        /// are allowed
+        /// @param caller function making the call
+        /// @param callee function called
+        /// @return true in case there was an error, false other case
+        bool add_call(Function *caller, Function *callee)
+        {
+            if (!contains(caller) || !contains(callee))
+                return true;
+
+            auto &vec = callees[caller];
+            if (std::find(vec.begin(), vec.end(), callee) != vec.end())
+                return true;
+
+            vec.push_back(callee);
+            callers[callee].push_back(caller);
+            return false;
         }
 
+        /// @brief Remove a call from a function to another, the calls
+        /// of the blocks of the caller are not changed
+        /// @return true if there was no such call, false other case
+        bool delete_call(Function *caller, Function *callee)
+        {
+            auto it = callees.find(caller);
+            if (it == callees.end())
+                return true;
+
+            auto &vec = it->second;
+            auto pos = std::find(vec.begin(), vec.end(), callee);
+            if (pos == vec.end())
+                return true;
+            vec.erase(pos);
+
+            auto &back = callers[callee];
+            back.erase(std::find(back.begin(), back.end(), caller));
+            return false;
+        }
+
+        /// @brief Get the functions called by a function
+        const std::vector<Function *> &get_callees(Function *func) const
+        {
+            static const std::vector<Function *> none;
+            auto it = callees.find(func);
+            return it != callees.end() ? it->second : none;
+        }
+
+        /// @brief Get the functions that call a function
+        const std::vector<Function *> &get_callers(Function *func) const
+        {
+            static const std::vector<Function *> none;
+            auto it = callers.find(func);
+            return it != callers.end() ? it->second : none;
+        }
+
+        /// @brief Validate all the functions of the module concurrently,
+        /// the problems of every function are collected instead of
+        /// stopping at the first one
+        /// @param threads number of threads, 0 to use one per hardware thread
+        /// @return report with the problems found
+        ValidationReport validate_all(unsigned threads = 0) const;
+
+        /// @brief Get the last function added that was not deleted
         Function *get_last_function()
         {
             return functions.back().get();
@@ -0,0 +1,91 @@
+//--------------------------------------------------------------------*- C++ -*-
+// CFG: example of CFG
+//
+// @file ModuleBuilder.hpp
+// @brief Concurrent construction of the functions of a Module
+
+#ifndef MODULEBUILDER_HPP
+#define MODULEBUILDER_HPP
+
+#include "cfg/Module.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace CFG
+{
+    /// @brief Builds the functions of a module from many threads at once.
+    /// Every thread gets its own Worker, with its own arena and its own list
+    /// of functions, so creating functions and blocks takes no lock: the
+    /// functions are sharded by the thread that builds them. A function must
+    /// only be modified by the thread that created it.
+    ///
+    /// The functions are not part of the module until freeze() is called,
+    /// which registers them in the module, hands it the arenas of the workers
+    /// and finalizes every function. The module must not be modified in any
+    /// other way while the builder is in use. Functions not frozen when the
+    /// builder is destroyed are discarded.
+    class ModuleBuilder
+    {
+    public:
+        /// @brief Builder of the functions of one thread
+        class Worker
+        {
+            /// @brief arena of the functions built by the worker, declared
+            /// first so it is released after the functions are destroyed
+            std::unique_ptr<Arena> arena;
+            /// @brief functions built by the worker with their order key
+            std::vector<std::pair<std::uint64_t, Module::function_ptr_t>> functions;
+            Module *module;
+
+            friend class ModuleBuilder;
+
+        public:
+            explicit Worker(Module *module) : arena(std::make_unique<Arena>()), module(module) {}
+
+            /// @brief Create a function, its blocks are allocated in the arena
+            /// of the worker through the usual BasicBlock::Create
+            /// @param name name of the function
+            /// @param key order of the function in the module, functions
+            /// with the same key keep the order in which they were created
+            /// by each worker
+            /// @return the new function
+            Function *create_function(std::string_view name, std::uint64_t key = 0);
+
+            /// @brief Get the number of functions built by the worker
+            std::size_t size() const { return functions.size(); }
+        };
+
+    private:
+        Module &module;
+        /// @brief serial number of the builder, it identifies the builder
+        /// in the worker cache of each thread
+        std::uint64_t serial;
+        /// @brief taken only when a thread gets its worker for the first time
+        std::mutex workers_lock;
+        std::vector<std::unique_ptr<Worker>> workers;
+
+    public:
+        explicit ModuleBuilder(Module &M);
+
+        ModuleBuilder(const ModuleBuilder &) = delete;
+        ModuleBuilder &operator=(const ModuleBuilder &) = delete;
+
+        /// @brief Get the worker of the calling thread, it is created on
+        /// the first call of each thread
+        Worker &get_worker();
+
+        /// @brief Add the functions of every worker to the module, sorted by
+        /// their key, and finalize them. The builder can be used again
+        /// afterwards for more functions.
+        /// @param threads number of threads to finalize the functions,
+        /// 0 to use one per hardware thread
+        void freeze(unsigned threads = 0);
+    };
+} // namespace CFG
+
+#endif
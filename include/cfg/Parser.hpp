@@ -0,0 +1,58 @@
+//--------------------------------------------------------------------*- C++ -*-
+// CFG: example of CFG
+//
+// @file Parser.hpp
+// @brief Loader of modules written as edge list or JSON text
+
+#ifndef PARSER_HPP
+#define PARSER_HPP
+
+#include "cfg/Module.hpp"
+
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "exceptions/parse_exception.hpp"
+
+namespace CFG
+{
+    /// @brief Formats accepted by the loader, the same text produced by
+    /// the exporter with ExportFormat::EdgeList and ExportFormat::Json
+    enum class InputFormat
+    {
+        /// @brief JSON if the first character is '{', edge list otherwise
+        Auto,
+        EdgeList,
+        Json,
+    };
+
+    /// @brief Build a module from its textual form. The text is parsed
+    /// in two steps: first it is split at the start of every function,
+    /// then the functions are parsed in parallel into plain records that
+    /// point into the text, and each thread builds the functions it parsed
+    /// with a ModuleBuilder. The functions of the module are in file order
+    /// and finalized. Only names with escape sequences are copied while
+    /// parsing.
+    ///
+    /// In the edge list format empty lines and lines starting with '#'
+    /// are ignored, block ids must go from 0 in order and the module line
+    /// is optional.
+    /// @param text text to parse
+    /// @param format format of the text
+    /// @param threads number of threads, 0 to use one per hardware thread
+    /// @param source name of the input used in the error messages
+    /// @throw exceptions::ParseException with the line of the first error
+    std::unique_ptr<Module> parse_module(std::string_view text, InputFormat format = InputFormat::Auto,
+                                         unsigned threads = 0, const std::string &source = "<input>");
+
+    /// @brief Map a file in memory and parse it with parse_module
+    /// @param path path of the file
+    /// @param format format of the file
+    /// @param threads number of threads, 0 to use one per hardware thread
+    /// @throw exceptions::ParseException if the file cannot be read or parsed
+    std::unique_ptr<Module> load_module(const std::string &path, InputFormat format = InputFormat::Auto,
+                                        unsigned threads = 0);
+} // namespace CFG
+
+#endif
@@ -0,0 +1,100 @@
+//--------------------------------------------------------------------*- C++ -*-
+// CFG: example of CFG
+//
+// @file Reachability.hpp
+// @brief Reusable scratch memory for the traversals over block ids
+
+#ifndef REACHABILITY_HPP
+#define REACHABILITY_HPP
+
+#include "cfg/BasicBlock.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace CFG
+{
+    /// @brief Bitset of visited blocks and stack of pending blocks used by
+    /// a depth first search. The memory is kept between searches, so once
+    /// it has grown to the size of the biggest function a traversal does
+    /// not allocate anymore. Every thread has its own context (see get()).
+    class ReachabilityContext
+    {
+        /// @brief one bit per block id
+        std::vector<std::uint64_t> visited;
+        /// @brief blocks pending to visit
+        std::vector<block_id_t> todo;
+
+    public:
+        /// @brief Get the context of the calling thread
+        static ReachabilityContext &get()
+        {
+            static thread_local ReachabilityContext context;
+            return context;
+        }
+
+        /// @brief Prepare the context for a graph of `n` blocks
+        void reset(std::size_t n)
+        {
+            visited.assign((n + 63) / 64, 0);
+            todo.clear();
+        }
+
+        /// @brief Mark a block as visited
+        /// @return true if the block was not visited before
+        bool visit(block_id_t id)
+        {
+            auto &word = visited[id / 64];
+            auto mask = std::uint64_t(1) << (id % 64);
+            if (word & mask)
+                return false;
+            word |= mask;
+            return true;
+        }
+
+        bool is_visited(block_id_t id) const
+        {
+            return (visited[id / 64] >> (id % 64)) & 1;
+        }
+
+        /// @brief Depth first search from `entry`
+        /// @param n number of blocks of the graph
+        /// @param entry block where the search starts
+        /// @param for_each_succ callable as for_each_succ(id, push) that
+        /// must call push(succ_id) for every sucessor of block `id`
+        /// @return number of blocks reached
+        template <typename ForEachSucc>
+        std::size_t search(std::size_t n, block_id_t entry, ForEachSucc for_each_succ)
+        {
+            reset(n);
+
+            std::size_t reached = 0;
+
+            auto push = [this](block_id_t id)
+            {
+                todo.push_back(id);
+            };
+
+            todo.push_back(entry);
+
+            while (!todo.empty())
+            {
+                auto node = todo.back();
+                todo.pop_back();
+
+                if (!visit(node))
+                    continue;
+
+                reached++;
+
+                for_each_succ(node, push);
+            }
+
+            return reached;
+        }
+    };
+} // namespace CFG
+
+#endif
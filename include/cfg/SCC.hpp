@@ -0,0 +1,102 @@
+//--------------------------------------------------------------------*- C++ -*-
+// CFG: example of CFG
+//
+// @file SCC.hpp
+// @brief Strongly connected components and condensation of a graph
+
+#ifndef SCC_HPP
+#define SCC_HPP
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace CFG
+{
+    class Function;
+
+    /// @brief Strongly connected components of a graph over dense node ids
+    /// given in CSR form, computed with the iterative version of Pearce's
+    /// algorithm, so deep graphs do not use the call stack, and with one
+    /// word per node on top of the result.
+    ///
+    /// Components are numbered in topological order of the condensation:
+    /// for every edge between two different components the source has the
+    /// smaller number. The condensation DAG is kept in CSR form.
+    class StronglyConnectedComponents
+    {
+    public:
+        using node_t = std::uint32_t;
+
+    private:
+        /// @brief component of each node
+        std::vector<node_t> component;
+        /// @brief nodes of each component, in CSR form
+        std::vector<std::uint32_t> member_offsets;
+        std::vector<node_t> members;
+        /// @brief edges between components, in CSR form
+        std::vector<std::uint32_t> dag_offsets;
+        std::vector<node_t> dag_targets;
+        /// @brief does the component have a cycle? false for
+        /// components of a single node without self loop
+        std::vector<bool> cyclic;
+
+    public:
+        /// @brief Empty result, for a graph without nodes
+        StronglyConnectedComponents() = default;
+
+        /// @brief Compute the components of a graph
+        /// @param offsets edges of node i are targets[offsets[i], offsets[i + 1])
+        /// @param targets targets of the edges
+        StronglyConnectedComponents(const std::vector<std::uint32_t> &offsets, const std::vector<node_t> &targets)
+        {
+            compute(offsets, targets);
+        }
+
+        /// @brief Compute the components of a graph, replacing the
+        /// previous result, the memory of the result is reused
+        /// @param offsets edges of node i are targets[offsets[i], offsets[i + 1])
+        /// @param targets targets of the edges
+        void compute(const std::vector<std::uint32_t> &offsets, const std::vector<node_t> &targets);
+
+        std::size_t num_nodes() const { return component.size(); }
+
+        std::size_t num_components() const { return cyclic.size(); }
+
+        /// @brief Get the component of a node
+        node_t get_component(node_t node) const { return component[node]; }
+
+        /// @brief Are two nodes in the same component?
+        bool same_component(node_t a, node_t b) const { return component[a] == component[b]; }
+
+        /// @brief Get the nodes of a component
+        /// @return pair of pointers with the range of nodes
+        std::pair<const node_t *, const node_t *> get_members(node_t comp) const
+        {
+            auto base = members.data();
+            return {base + member_offsets[comp], base + member_offsets[comp + 1]};
+        }
+
+        /// @brief Get the components reached by the edges leaving a
+        /// component, every component appears once
+        /// @return pair of pointers with the range of components
+        std::pair<const node_t *, const node_t *> get_successors(node_t comp) const
+        {
+            auto base = dag_targets.data();
+            return {base + dag_offsets[comp], base + dag_offsets[comp + 1]};
+        }
+
+        /// @brief Does the component contain a cycle?
+        bool is_cyclic(node_t comp) const { return cyclic[comp]; }
+    };
+
+    /// @brief Strongly connected components of the blocks of a function,
+    /// node ids are block ids
+    class BlockSCCs : public StronglyConnectedComponents
+    {
+    public:
+        explicit BlockSCCs(const Function &F);
+    };
+} // namespace CFG
+
+#endif
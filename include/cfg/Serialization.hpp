@@ -0,0 +1,266 @@
+//--------------------------------------------------------------------*- C++ -*-
+// CFG: example of CFG
+//
+// @file Serialization.hpp
+// @brief Binary on-disk format for a Module and a memory mapped reader
+
+#ifndef SERIALIZATION_HPP
+#define SERIALIZATION_HPP
+
+#include "cfg/Module.hpp"
+#include "exceptions/serialization_exception.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace CFG
+{
+    /// @brief Layout of the binary format. All the values are written
+    /// in the byte order of the machine, the header records it so a file
+    /// from a machine with a different order is rejected. Every section
+    /// is an array of fixed size records aligned to 8 bytes:
+    ///
+    ///  - strings: names of the module, functions and blocks and edge tags,
+    ///    every different string is stored once
+    ///  - tags: (offset, length) of each edge tag in the strings
+    ///  - functions: one FunctionRecord per function
+    ///  - blocks: one BlockRecord per block, grouped by function
+    ///  - succ_offsets/pred_offsets: CSR offsets of each function, one per
+    ///    block plus one, relative to the first edge of the function
+    ///  - succ_targets/succ_tags/pred_sources: CSR edges, with block ids
+    ///    local to the function and tag ids from the tags section
+    namespace format
+    {
+        constexpr char magic[4] = {'C', 'F', 'G', 'B'};
+        constexpr std::uint32_t version = 1;
+        constexpr std::uint32_t byte_order_mark = 0x01020304;
+
+        struct StringRef
+        {
+            std::uint32_t offset;
+            std::uint32_t length;
+        };
+
+        struct Header
+        {
+            char magic[4];
+            std::uint32_t version;
+            std::uint32_t byte_order;
+            std::uint32_t num_functions;
+            std::uint64_t num_blocks;
+            std::uint64_t num_edges;
+            std::uint64_t num_pred_edges;
+            std::uint32_t num_tags;
+            StringRef module_name;
+            std::uint32_t reserved;
+            /// @brief offsets of the sections from the start of the file
+            std::uint64_t strings;
+            std::uint64_t strings_size;
+            std::uint64_t tags;
+            std::uint64_t functions;
+            std::uint64_t blocks;
+            std::uint64_t succ_offsets;
+            std::uint64_t succ_targets;
+            std::uint64_t succ_tags;
+            std::uint64_t pred_offsets;
+            std::uint64_t pred_sources;
+        };
+
+        struct FunctionRecord
+        {
+            StringRef name;
+            std::uint32_t num_blocks;
+            std::uint32_t reserved;
+            /// @brief index of the first block in the blocks section
+            std::uint64_t first_block;
+            /// @brief index of the first offset in the offset sections
+            std::uint64_t first_offset;
+            /// @brief index of the first edge in the sucessor sections
+            std::uint64_t first_edge;
+            /// @brief index of the first edge in the predecessor section
+            std::uint64_t first_pred_edge;
+        };
+
+        struct BlockRecord
+        {
+            std::uint64_t start_addr;
+            std::uint64_t end_addr;
+            StringRef name;
+            std::uint32_t flags;
+            std::uint32_t reserved;
+        };
+
+        /// @brief flag of BlockRecord for the entry block
+        constexpr std::uint32_t block_entry = 1;
+    } // namespace format
+
+    /// @brief Write a module to a file in the binary format
+    /// @param M module to write
+    /// @param path path of the file
+    /// @throw exceptions::SerializationException if the file cannot be written
+    /// or the module does not fit in the 32 bit fields of the format: more
+    /// than 4 GiB of strings, or more than 2^32 functions, tags, or blocks
+    /// or edges in a function
+    void write_module(const Module &M, const std::string &path);
+
+    /// @brief Read only view of a module stored in the binary format, the
+    /// file is mapped in memory and the views point directly to its contents.
+    /// Opening the file only checks the header and the bounds of the sections,
+    /// the records of a function are checked the first time it is requested,
+    /// so only the pages of the functions used are read.
+    class MappedModule
+    {
+        /// @brief mapped memory
+        const std::byte *data{nullptr};
+        /// @brief size of the mapping
+        std::size_t size{0};
+        /// @brief header of the file
+        const format::Header *header{nullptr};
+        /// @brief one flag per function, set once its records are checked
+        std::unique_ptr<std::atomic<bool>[]> checked;
+
+        /// @brief Check the records of a function: its strings, the range of
+        /// its blocks and edges, the edge targets and tag ids, and that its
+        /// predecessors are its sucessors reversed, so the views never read
+        /// out of the mapping or disagree with each other
+        /// @throw exceptions::SerializationException if a record is invalid
+        void check_function(std::size_t f) const;
+
+        template <typename T>
+        const T *section(std::uint64_t offset) const
+        {
+            return reinterpret_cast<const T *>(data + offset);
+        }
+
+        std::string_view string(format::StringRef ref) const
+        {
+            return {section<char>(header->strings) + ref.offset, ref.length};
+        }
+
+    public:
+        /// @brief Edge leaving a block
+        struct Edge
+        {
+            block_id_t target;
+            std::string_view tag;
+        };
+
+        /// @brief View of a block of a mapped function
+        class BlockView
+        {
+            const MappedModule *module;
+            const format::FunctionRecord *function;
+            block_id_t id;
+
+        public:
+            BlockView(const MappedModule *module, const format::FunctionRecord *function, block_id_t id)
+                : module(module), function(function), id(id) {}
+
+            block_id_t get_id() const { return id; }
+
+            const format::BlockRecord &record() const
+            {
+                return module->section<format::BlockRecord>(module->header->blocks)[function->first_block + id];
+            }
+
+            std::string_view get_name() const { return module->string(record().name); }
+
+            std::uint64_t get_start_addr() const { return record().start_addr; }
+
+            std::uint64_t get_end_addr() const { return record().end_addr; }
+
+            bool get_entry_block() const { return record().flags & format::block_entry; }
+
+            /// @brief Get the number of sucessors of the block
+            std::size_t num_sucessors() const { return succ_end() - succ_begin(); }
+
+            /// @brief Get a sucessor of the block
+            /// @param i index of the sucessor, lower than num_sucessors()
+            Edge get_sucessor(std::size_t i) const
+            {
+                auto e = function->first_edge + succ_begin() + i;
+                auto tag = module->section<format::StringRef>(module->header->tags)[module->section<tag_id_t>(module->header->succ_tags)[e]];
+                return {module->section<block_id_t>(module->header->succ_targets)[e], module->string(tag)};
+            }
+
+            /// @brief Get the number of predecessors of the block
+            std::size_t num_predecessors() const
+            {
+                auto offsets = module->section<std::uint32_t>(module->header->pred_offsets) + function->first_offset;
+                return offsets[id + 1] - offsets[id];
+            }
+
+            /// @brief Get a predecessor of the block
+            /// @param i index of the predecessor, lower than num_predecessors()
+            block_id_t get_predecessor(std::size_t i) const
+            {
+                auto offsets = module->section<std::uint32_t>(module->header->pred_offsets) + function->first_offset;
+                return module->section<block_id_t>(module->header->pred_sources)[function->first_pred_edge + offsets[id] + i];
+            }
+
+        private:
+            std::uint32_t succ_begin() const
+            {
+                return module->section<std::uint32_t>(module->header->succ_offsets)[function->first_offset + id];
+            }
+
+            std::uint32_t succ_end() const
+            {
+                return module->section<std::uint32_t>(module->header->succ_offsets)[function->first_offset + id + 1];
+            }
+        };
+
+        /// @brief View of a mapped function
+        class FunctionView
+        {
+            const MappedModule *module;
+            const format::FunctionRecord *function;
+
+        public:
+            FunctionView(const MappedModule *module, const format::FunctionRecord *function)
+                : module(module), function(function) {}
+
+            std::string_view get_name() const { return module->string(function->name); }
+
+            std::size_t num_blocks() const { return function->num_blocks; }
+
+            BlockView get_basic_block(block_id_t id) const { return {module, function, id}; }
+        };
+
+        /// @brief Map a file and check its header and the bounds of its sections
+        /// @param path path of the file
+        /// @throw exceptions::SerializationException if the file cannot be
+        /// mapped or it is not a valid module
+        explicit MappedModule(const std::string &path);
+
+        MappedModule(const MappedModule &) = delete;
+        MappedModule &operator=(const MappedModule &) = delete;
+
+        ~MappedModule();
+
+        std::string_view get_name() const { return string(header->module_name); }
+
+        std::size_t num_functions() const { return header->num_functions; }
+
+        /// @brief Get a view of a function, its records are checked the first
+        /// time it is requested, one pass over its blocks and edges
+        /// @param i index of the function, lower than num_functions()
+        /// @throw exceptions::SerializationException if its records are invalid
+        FunctionView get_function(std::size_t i) const
+        {
+            if (!checked[i].load(std::memory_order_acquire))
+                check_function(i);
+            return {this, section<format::FunctionRecord>(header->functions) + i};
+        }
+
+        /// @brief Build a mutable Module with the contents of the file
+        /// @throw exceptions::SerializationException if a function is invalid
+        std::unique_ptr<Module> to_module() const;
+    };
+} // namespace CFG
+
+#endif
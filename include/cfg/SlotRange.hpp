@@ -0,0 +1,81 @@
+//--------------------------------------------------------------------*- C++ -*-
+// CFG: example of CFG
+//
+// @file SlotRange.hpp
+// @brief View of the live elements of a vector with empty slots
+
+#ifndef SLOTRANGE_HPP
+#define SLOTRANGE_HPP
+
+#include <cstddef>
+#include <iterator>
+#include <vector>
+
+namespace CFG
+{
+    /// @brief View of a vector of owning pointers indexed by id, where
+    /// a deleted element leaves its slot empty so the ids of the rest
+    /// do not change. The view iterates the elements in id order and
+    /// skips the empty slots, size() is the number of live elements.
+    template <typename Ptr>
+    class SlotRange
+    {
+        const Ptr *first{nullptr};
+        const Ptr *last{nullptr};
+        std::size_t count{0};
+
+    public:
+        class iterator
+        {
+            const Ptr *cur{nullptr};
+            const Ptr *last{nullptr};
+
+            void skip()
+            {
+                while (cur != last && !*cur)
+                    ++cur;
+            }
+
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = Ptr;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const Ptr *;
+            using reference = const Ptr &;
+
+            iterator() = default;
+            iterator(const Ptr *cur, const Ptr *last) : cur(cur), last(last) { skip(); }
+
+            reference operator*() const { return *cur; }
+            pointer operator->() const { return cur; }
+
+            iterator &operator++()
+            {
+                ++cur;
+                skip();
+                return *this;
+            }
+
+            iterator operator++(int)
+            {
+                auto it = *this;
+                ++*this;
+                return it;
+            }
+
+            bool operator==(const iterator &other) const { return cur == other.cur; }
+        };
+
+        SlotRange() = default;
+        SlotRange(const std::vector<Ptr> &slots, std::size_t count)
+            : first(slots.data()), last(slots.data() + slots.size()), count(count) {}
+
+        iterator begin() const { return {first, last}; }
+        iterator end() const { return {last, last}; }
+
+        std::size_t size() const { return count; }
+        bool empty() const { return count == 0; }
+    };
+} // namespace CFG
+
+#endif // SLOTRANGE_HPP
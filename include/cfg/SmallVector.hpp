@@ -0,0 +1,178 @@
+//--------------------------------------------------------------------*- C++ -*-
+// CFG: example of CFG
+//
+// @file SmallVector.hpp
+// @brief Vector with inline capacity for a few trivially copyable elements
+
+#ifndef SMALLVECTOR_HPP
+#define SMALLVECTOR_HPP
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace CFG
+{
+    /// @brief Vector that keeps up to N elements inside the object and only
+    /// allocates when it grows past them. Elements are copied with memcpy,
+    /// so they must be trivially copyable. Any modification invalidates the
+    /// pointers to the elements.
+    template <typename T, std::uint32_t N>
+    class SmallVector
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "elements are moved with memcpy");
+        static_assert(N > 0, "use std::vector without inline capacity");
+
+        /// @brief the inline elements, or the heap ones once capacity > N
+        union
+        {
+            T inline_elements[N];
+            T *heap;
+        };
+        std::uint32_t count{0};
+        std::uint32_t capacity{N};
+
+        bool is_inline() const { return capacity == N; }
+
+        void grow(std::uint32_t min_capacity)
+        {
+            auto new_capacity = capacity * 2 > min_capacity ? capacity * 2 : min_capacity;
+            auto elements = static_cast<T *>(::operator new(sizeof(T) * new_capacity));
+            std::memcpy(elements, data(), sizeof(T) * count);
+            release();
+            heap = elements;
+            capacity = new_capacity;
+        }
+
+        void release()
+        {
+            if (!is_inline())
+                ::operator delete(heap);
+        }
+
+    public:
+        using value_type = T;
+        using iterator = T *;
+        using const_iterator = const T *;
+
+        SmallVector() {}
+
+        SmallVector(const SmallVector &) = delete;
+        SmallVector &operator=(const SmallVector &) = delete;
+
+        /// @brief the heap elements are taken as they are, the inline ones
+        /// are copied, `other` is left empty
+        SmallVector(SmallVector &&other) noexcept
+        {
+            *this = std::move(other);
+        }
+
+        SmallVector &operator=(SmallVector &&other) noexcept
+        {
+            if (this == &other)
+                return *this;
+
+            release();
+            if (other.is_inline())
+            {
+                std::memcpy(inline_elements, other.inline_elements, sizeof(T) * other.count);
+                capacity = N;
+            }
+            else
+            {
+                heap = other.heap;
+                capacity = other.capacity;
+                other.capacity = N;
+            }
+            count = other.count;
+            other.count = 0;
+            return *this;
+        }
+
+        ~SmallVector() { release(); }
+
+        T *data() { return is_inline() ? inline_elements : heap; }
+
+        const T *data() const { return is_inline() ? inline_elements : heap; }
+
+        std::uint32_t size() const { return count; }
+
+        bool empty() const { return count == 0; }
+
+        /// @brief Get the bytes allocated out of the object
+        std::size_t heap_bytes() const { return is_inline() ? 0 : sizeof(T) * capacity; }
+
+        T *begin() { return data(); }
+
+        T *end() { return data() + count; }
+
+        const T *begin() const { return data(); }
+
+        const T *end() const { return data() + count; }
+
+        T &operator[](std::uint32_t i)
+        {
+            assert(i < count);
+            return data()[i];
+        }
+
+        const T &operator[](std::uint32_t i) const
+        {
+            assert(i < count);
+            return data()[i];
+        }
+
+        T &back() { return data()[count - 1]; }
+
+        const T &back() const { return data()[count - 1]; }
+
+        void reserve(std::uint32_t min_capacity)
+        {
+            if (min_capacity > capacity)
+                grow(min_capacity);
+        }
+
+        void push_back(const T &value)
+        {
+            if (count == capacity)
+            {
+                /// `value` may be one of the elements
+                T copy = value;
+                grow(count + 1);
+                data()[count++] = copy;
+                return;
+            }
+            data()[count++] = value;
+        }
+
+        void pop_back()
+        {
+            assert(count > 0);
+            count--;
+        }
+
+        /// @brief Remove an element keeping the order of the rest
+        void erase(T *position)
+        {
+            assert(position >= begin() && position < end());
+            std::memmove(position, position + 1, sizeof(T) * (end() - position - 1));
+            count--;
+        }
+
+        void clear() { count = 0; }
+
+        /// @brief Remove every element and give back the heap memory
+        void reset()
+        {
+            release();
+            capacity = N;
+            count = 0;
+        }
+    };
+} // namespace CFG
+
+#endif
@@ -0,0 +1,193 @@
+//--------------------------------------------------------------------*- C++ -*-
+// CFG: example of CFG
+//
+// @file Stats.hpp
+// @brief Optional instrumentation of the graph operations, and memory
+// and shape statistics of functions and modules
+//
+// The timers of the operations are only compiled in when the library is
+// built with CFG_ENABLE_STATS, otherwise CFG_STATS_SCOPE expands to
+// nothing. Once compiled in they are still off until Stats::set_enabled.
+// Every call is counted, but reading the cycle counter costs more than
+// many of the operations, so only one call out of get_sample_period()
+// is timed. A period of 1 times every call.
+
+#ifndef STATS_HPP
+#define STATS_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace CFG
+{
+    class Function;
+    class Module;
+    class OutputBuffer;
+
+    /// @brief Operations timed by the instrumentation
+    enum class StatOp : std::uint8_t
+    {
+        AddSucessor,
+        AddSuccessors,
+        DeleteBasicBlock,
+        ValidateFunction,
+        DumpFunctionDot,
+        Count,
+    };
+
+    /// @brief Get the name of an operation, for reports
+    std::string_view stat_op_name(StatOp op);
+
+    /// @brief Counters of the timed operations. Every thread updates its
+    /// own counters without atomic operations, the reports add the
+    /// counters of all the threads, those still running and those that
+    /// already finished.
+    class Stats
+    {
+    public:
+        /// @brief buckets of the latency histograms, bucket b counts the
+        /// calls that took [2^(b-1), 2^b) cycles, bucket 0 the ones of 0
+        static constexpr std::size_t buckets = 64;
+
+        /// @brief default value of the sample period
+        static constexpr std::uint32_t default_sample_period = 16;
+
+        /// @brief Counters of one operation
+        struct Snapshot
+        {
+            /// @brief calls of the operation
+            std::uint64_t count{0};
+            /// @brief calls timed, and the cycles and histogram of those
+            std::uint64_t timed{0};
+            std::uint64_t cycles{0};
+            std::array<std::uint64_t, buckets> histogram{};
+        };
+
+    private:
+        static inline std::atomic<bool> enabled{false};
+        static inline std::atomic<std::uint32_t> sample_period{default_sample_period};
+
+    public:
+        /// @brief Is the instrumentation compiled in?
+        static constexpr bool compiled_in()
+        {
+#ifdef CFG_ENABLE_STATS
+            return true;
+#else
+            return false;
+#endif
+        }
+
+        /// @brief Turn the timers on or off, nothing is done when
+        /// they are not compiled in
+        static void set_enabled(bool on) { enabled.store(on && compiled_in(), std::memory_order_relaxed); }
+
+        static bool is_enabled() { return compiled_in() && enabled.load(std::memory_order_relaxed); }
+
+        /// @brief Time one call out of `period`, at least 1
+        static void set_sample_period(std::uint32_t period) { sample_period.store(period ? period : 1, std::memory_order_relaxed); }
+
+        static std::uint32_t get_sample_period() { return sample_period.load(std::memory_order_relaxed); }
+
+        /// @brief Read the cycle counter, or the steady clock in
+        /// nanoseconds where there is no cycle counter
+        static std::uint64_t read_cycles()
+        {
+#if defined(__x86_64__) || defined(__i386__)
+            return __rdtsc();
+#else
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+        }
+
+        /// @brief Count a call of an operation
+        /// @return true if the call has to be timed
+        static bool begin(StatOp op);
+
+        /// @brief Add the cycles of a timed call
+        static void record(StatOp op, std::uint64_t cycles);
+
+        /// @brief Get the counters of an operation
+        static Snapshot get(StatOp op);
+
+        /// @brief Set every counter to zero, the calls running in
+        /// other threads at the same time may still be counted
+        static void reset();
+
+        /// @brief Write the counters of every operation as a JSON object
+        static void export_json(OutputBuffer &out);
+    };
+
+    /// @brief Counts the call of the operation where it lives, and times
+    /// it if it is sampled, when the timers are on
+    class StatsScope
+    {
+        std::uint64_t start{0};
+        StatOp op;
+        bool active{false};
+
+    public:
+        explicit StatsScope(StatOp op) : op(op)
+        {
+            if (Stats::is_enabled() && Stats::begin(op))
+            {
+                active = true;
+                start = Stats::read_cycles();
+            }
+        }
+
+        StatsScope(const StatsScope &) = delete;
+        StatsScope &operator=(const StatsScope &) = delete;
+
+        ~StatsScope()
+        {
+            if (active)
+                Stats::record(op, Stats::read_cycles() - start);
+        }
+    };
+
+#ifdef CFG_ENABLE_STATS
+#define CFG_STATS_SCOPE(op) ::CFG::StatsScope cfg_stats_scope(::CFG::StatOp::op)
+#else
+#define CFG_STATS_SCOPE(op) ((void)0)
+#endif
+
+    /// @brief Memory and shape of a function, computed on request
+    struct FunctionStats
+    {
+        std::size_t blocks{0};
+        std::size_t edges{0};
+        /// @brief number of blocks with each number of sucessors
+        std::vector<std::size_t> out_degree;
+        /// @brief longest of the shortest paths from the entry to the
+        /// reachable blocks, in edges
+        std::size_t max_depth{0};
+        /// @brief bytes of the block records, in the arena
+        std::size_t block_bytes{0};
+        /// @brief bytes of the edges: the lists spilled out of the blocks
+        /// and the packed edges of a finalized function
+        std::size_t edge_bytes{0};
+        /// @brief bytes reserved by the instruction buffer
+        std::size_t instruction_bytes{0};
+
+        std::size_t total_bytes() const { return block_bytes + edge_bytes + instruction_bytes; }
+    };
+
+    /// @brief Compute the statistics of a function
+    FunctionStats collect_stats(const Function &F);
+
+    /// @brief Write the statistics of a module and every function as a
+    /// JSON object, with the counters of the operations
+    void export_module_stats(const Module &M, OutputBuffer &out);
+} // namespace CFG
+
+#endif
@@ -0,0 +1,118 @@
+//--------------------------------------------------------------------*- C++ -*-
+// CFG: example of CFG
+//
+// @file StructuralHash.hpp
+// @brief Structural hashing and isomorphism of control flow graphs, and
+// an index of the duplicated functions of a Module
+
+#ifndef STRUCTURALHASH_HPP
+#define STRUCTURALHASH_HPP
+
+#include "cfg/BasicBlock.hpp"
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace CFG
+{
+    class Function;
+    class Module;
+
+    /// @brief Hash of the shape of the graph of a function, with the
+    /// refinement of Weisfeiler and Lehman: every block starts with a color
+    /// from its degrees and its entry flag, and each round mixes into the
+    /// color of a block the colors of its sucessors and predecessors with the
+    /// tags of the edges. The hash mixes the colors of all the blocks, so it
+    /// does not depend on the ids, names or addresses of the blocks.
+    ///
+    /// Isomorphic graphs always have the same hash, different graphs almost
+    /// always have different ones; is_isomorphic gives the exact answer.
+    /// Through Function::get_analysis the result is computed once and kept
+    /// until the graph changes.
+    class StructuralHash
+    {
+    public:
+        /// @brief rounds of refinement, each one lets the color of a
+        /// block see one more edge away
+        static constexpr unsigned rounds = 5;
+
+    private:
+        /// @brief final color of each block
+        std::vector<std::uint64_t> colors;
+        std::uint64_t hash{0};
+
+    public:
+        explicit StructuralHash(const Function &F);
+
+        std::uint64_t get_hash() const { return hash; }
+
+        /// @brief Get the color of a block, blocks mapped to each other by
+        /// an isomorphism have the same color
+        std::uint64_t get_color(block_id_t id) const { return colors[id]; }
+
+        std::span<const std::uint64_t> get_colors() const { return colors; }
+    };
+
+    /// @brief Check if the graphs of two functions are the same up to the
+    /// ids of the blocks: a bijection between their blocks keeps the entry
+    /// flags and maps every edge to an edge with the same tag. Names,
+    /// addresses and instructions are not compared.
+    ///
+    /// Edges leaving a block have different tags, so once a block is mapped
+    /// its sucessors are too; the search only has to choose for the blocks
+    /// not reachable from the ones already mapped, among the blocks of the
+    /// same color.
+    /// @param A first function
+    /// @param B second function
+    /// @param mapping if not null, receives the block of B of each block of A,
+    /// indexed by block id, the ids of deleted blocks of A are mapped to ~0
+    /// @return true if the graphs are isomorphic
+    bool is_isomorphic(const Function &A, const Function &B, std::vector<block_id_t> *mapping = nullptr);
+
+    /// @brief Classes of the functions of a module with isomorphic graphs.
+    /// Each class is represented by its first function in module order, the
+    /// canonical one, whose analyses can be reused by the rest of the class
+    /// through the block mapping of is_isomorphic.
+    ///
+    /// The hashes are computed in parallel, the functions with the same hash
+    /// are then confirmed with is_isomorphic, also in parallel. It must be
+    /// built again after the functions change.
+    class DedupIndex
+    {
+        const Module *module;
+        /// @brief id of the canonical function of each function id
+        std::vector<std::uint32_t> canonical;
+        /// @brief structural hash of each function id
+        std::vector<std::uint64_t> hashes;
+        /// @brief number of functions indexed, the deleted ones excluded
+        std::size_t count{0};
+        std::size_t classes{0};
+
+    public:
+        /// @brief Build the index of a module
+        /// @param M module to index
+        /// @param threads number of threads, 0 to use one per hardware thread
+        explicit DedupIndex(const Module &M, unsigned threads = 0);
+
+        std::size_t num_functions() const { return count; }
+
+        /// @brief Get the number of classes, the functions that remain
+        /// once the duplicates are removed
+        std::size_t num_classes() const { return classes; }
+
+        std::size_t num_duplicates() const { return count - classes; }
+
+        std::uint64_t get_hash(std::uint32_t id) const { return hashes[id]; }
+
+        /// @brief Get the id of the canonical function of the class of a function
+        std::uint32_t get_canonical(std::uint32_t id) const { return canonical[id]; }
+
+        /// @brief Get the canonical function of the class of a function
+        const Function *get_canonical(const Function *F) const;
+
+        bool is_canonical(std::uint32_t id) const { return canonical[id] == id; }
+    };
+} // namespace CFG
+
+#endif
@@ -0,0 +1,138 @@
+//--------------------------------------------------------------------*- C++ -*-
+// CFG: example of CFG
+//
+// @file ThreadPool.hpp
+// @brief Work stealing thread pool used by the module wide passes
+
+#ifndef THREADPOOL_HPP
+#define THREADPOOL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace CFG
+{
+    /// @brief Pool of threads where every worker owns a queue of tasks.
+    /// A worker takes tasks from the back of its own queue and, when it
+    /// runs out of work, steals from the front of the queues of the others.
+    /// Tasks must not throw, errors have to be reported by the task itself.
+    class ThreadPool
+    {
+    public:
+        using task_t = std::function<void()>;
+
+    private:
+        /// @brief queue of tasks of one worker
+        struct Queue
+        {
+            std::mutex lock;
+            std::deque<task_t> tasks;
+        };
+
+        /// @brief one queue per worker
+        std::vector<std::unique_ptr<Queue>> queues;
+        /// @brief worker threads
+        std::vector<std::thread> workers;
+        /// @brief lock for the condition variables
+        std::mutex wake_lock;
+        /// @brief signaled when new tasks are queued or the pool stops
+        std::condition_variable wake;
+        /// @brief signaled when there are no pending tasks, and when the
+        /// last task of a parallel_for finishes
+        std::condition_variable done;
+        /// @brief tasks waiting in the queues
+        std::atomic<std::size_t> queued{0};
+        /// @brief tasks queued or running
+        std::atomic<std::size_t> pending{0};
+        /// @brief queue used by the next task submitted from outside the pool
+        std::atomic<std::size_t> next_queue{0};
+        /// @brief is the pool being destroyed?
+        bool stopping{false};
+
+        /// @brief Run one task, from the queue `self` or stolen from another
+        /// @param self index of the queue of the calling worker
+        /// @return true if a task was run
+        bool try_run(std::size_t self);
+
+        /// @brief Get the queue of the calling thread, 0 if it is not a worker
+        std::size_t self_index() const;
+
+        /// @brief main loop of a worker
+        /// @param index index of the worker
+        void worker_loop(std::size_t index);
+
+    public:
+        /// @brief Create the pool
+        /// @param threads number of workers, 0 to use one per hardware thread
+        explicit ThreadPool(unsigned threads = 0);
+
+        ThreadPool(const ThreadPool &) = delete;
+        ThreadPool &operator=(const ThreadPool &) = delete;
+
+        ~ThreadPool();
+
+        /// @brief Get the number of workers of the pool
+        std::size_t size() const { return workers.size(); }
+
+        /// @brief Queue a task, tasks submitted from a worker go to its own queue
+        /// @param task task to run
+        void submit(task_t task);
+
+        /// @brief Wait until every submitted task has finished, the calling
+        /// thread runs tasks too while it waits. It must not be called from
+        /// inside a task, use parallel_for for nested parallelism.
+        void wait();
+
+        /// @brief Run fn(i) for every i in [0, n) and wait for all of them,
+        /// the calling thread runs tasks while it waits so it can be used
+        /// from inside another task
+        /// @param n number of iterations
+        /// @param fn function to call with each index
+        /// @param grain number of consecutive indexes run by a single task
+        template <typename Fn>
+        void parallel_for(std::size_t n, Fn fn, std::size_t grain = 1)
+        {
+            grain = std::max<std::size_t>(grain, 1);
+
+            auto remaining = std::make_shared<std::atomic<std::size_t>>((n + grain - 1) / grain);
+
+            for (std::size_t begin = 0; begin < n; begin += grain)
+            {
+                auto end = std::min(n, begin + grain);
+                submit([=, this]()
+                       {
+                           for (auto i = begin; i < end; i++)
+                               fn(i);
+                           if (remaining->fetch_sub(1) == 1)
+                           {
+                               std::lock_guard<std::mutex> guard(wake_lock);
+                               done.notify_all();
+                           }
+                       });
+            }
+
+            /// as wait(), but only for the tasks of this loop: run tasks while
+            /// there are queued ones and sleep while the last ones are running
+            auto self = self_index();
+            while (remaining->load() > 0)
+            {
+                if (try_run(self))
+                    continue;
+
+                std::unique_lock<std::mutex> lock(wake_lock);
+                done.wait(lock, [&]()
+                          { return remaining->load() == 0 || queued.load() > 0; });
+            }
+        }
+    };
+} // namespace CFG
+
+#endif
@@ -0,0 +1,53 @@
+//--------------------------------------------------------------------*- C++ -*-
+// CFG: example of CFG
+//
+// @file ValidationReport.hpp
+// @brief Result of validating all the functions of a Module
+
+#ifndef VALIDATIONREPORT_HPP
+#define VALIDATIONREPORT_HPP
+
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace CFG
+{
+    class Function;
+
+    /// @brief Problem found while validating a function
+    struct ValidationDiagnostic
+    {
+        /// @brief kind of problem, one per validation exception
+        enum class kind_t
+        {
+            NoEntryBlock,
+            MultipleEntryBlock,
+            NoConnectedBlock,
+        };
+
+        /// @brief function with the problem
+        const Function *function;
+        /// @brief kind of problem
+        kind_t kind;
+        /// @brief message of the exception
+        std::string message;
+    };
+
+    /// @brief Diagnostics of all the functions of a module,
+    /// sorted by the position of the function in the module
+    struct ValidationReport
+    {
+        /// @brief number of functions validated
+        std::size_t functions_checked{0};
+        /// @brief problems found
+        std::vector<ValidationDiagnostic> diagnostics;
+
+        bool ok() const { return diagnostics.empty(); }
+
+        friend std::ostream &operator<<(std::ostream &os, const ValidationReport &report);
+    };
+} // namespace CFG
+
+#endif
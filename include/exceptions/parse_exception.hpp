@@ -0,0 +1,34 @@
+//--------------------------------------------------------------------*- C++ -*-
+// CFG: example of CFG
+//
+// @file parse_exception.hpp
+// @brief Exception for errors in the textual input of the loader
+
+#ifndef PARSE_EXCEPTION_HPP
+#define PARSE_EXCEPTION_HPP
+
+namespace exceptions
+{
+    /// @brief Exception when a textual module cannot be loaded
+    class ParseException : public std::exception
+    {
+        /// @brief message to show with the exception
+        std::string _msg;
+
+    public:
+        
+        /// @brief Constructor of exception
+        /// @param msg message to show to the user
+        ParseException(const std::string &msg) : _msg(msg)
+        {}
+
+        /// @brief Return error message
+        /// @return error message in a c string style
+        virtual const char* what() const noexcept override
+        {
+            return _msg.c_str();
+        }
+    };
+} // namespace exceptions
+
+#endif
@@ -0,0 +1,34 @@
+//--------------------------------------------------------------------*- C++ -*-
+// CFG: example of CFG
+//
+// @file serialization_exception.hpp
+// @brief Exception for errors reading or writing serialized modules
+
+#ifndef SERIALIZATION_EXCEPTION_HPP
+#define SERIALIZATION_EXCEPTION_HPP
+
+namespace exceptions
+{
+    /// @brief Exception when a module cannot be written or loaded
+    class SerializationException : public std::exception
+    {
+        /// @brief message to show with the exception
+        std::string _msg;
+
+    public:
+        
+        /// @brief Constructor of exception
+        /// @param msg message to show to the user
+        SerializationException(const std::string &msg) : _msg(msg)
+        {}
+
+        /// @brief Return error message
+        /// @return error message in a c string style
+        virtual const char* what() const noexcept override
+        {
+            return _msg.c_str();
+        }
+    };
+} // namespace exceptions
+
+#endif
\ No newline at end of file
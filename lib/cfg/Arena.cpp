@@ -0,0 +1,49 @@
+#include "cfg/Arena.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace CFG;
+
+void Arena::grow(std::size_t size, std::size_t align)
+{
+    auto needed = size + align;
+    auto chunk_size = std::max(next_chunk_size, needed);
+
+    chunks.emplace_back(new std::byte[chunk_size]);
+    cur = chunks.back().get();
+    end = cur + chunk_size;
+    bytes_reserved += chunk_size;
+
+    next_chunk_size = std::min(next_chunk_size * 2, max_chunk_size);
+}
+
+std::string_view Arena::intern(std::string_view str)
+{
+    auto it = strings.find(str);
+    if (it != strings.end())
+        return *it;
+
+    auto mem = static_cast<char *>(allocate(str.size() + 1, alignof(char)));
+    /// an empty view may have no data at all
+    if (!str.empty())
+        std::memcpy(mem, str.data(), str.size());
+    mem[str.size()] = '\0';
+
+    std::string_view interned{mem, str.size()};
+    strings.insert(interned);
+    return interned;
+}
+
+tag_id_t Arena::intern_tag(std::string_view tag)
+{
+    auto it = tag_ids.find(tag);
+    if (it != tag_ids.end())
+        return it->second;
+
+    auto id = static_cast<tag_id_t>(tags.size());
+    auto interned = intern(tag);
+    tags.push_back(interned);
+    tag_ids.emplace(interned, id);
+    return id;
+}
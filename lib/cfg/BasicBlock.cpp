@@ -2,14 +2,87 @@
 #include "cfg/BasicBlock.hpp"
 #include "cfg/Function.hpp"
 
+#include <cstddef>
+#include <cstring>
+
 namespace CFG
 {
+    BasicBlock::BasicBlock(std::string_view Name, Function *Parent)
+        : parent_function(Parent)
+    {
+        static_assert(sizeof(succ_edge_t) == 16, "a sucessor takes two words");
+        static_assert(offsetof(BasicBlock, succ_edges) + sizeof(succ_edges) <= 64,
+                      "the inline sucessors share the cache line of start_addr/end_addr");
+
+        if (Parent)
+            name = Parent->get_arena().intern(Name);
+        else if (!Name.empty())
+        {
+            orphan_name = std::make_unique<char[]>(Name.size());
+            std::memcpy(orphan_name.get(), Name.data(), Name.size());
+            name = {orphan_name.get(), Name.size()};
+        }
+    }
+
     BasicBlock *BasicBlock::Create(std::string_view Name, Function *Parent)
     {
         assert(Parent && "Parent Function must be specified");
 
-        Parent->add_basic_block(std::make_unique<BasicBlock>(Name, Parent));
+        auto bb = Parent->get_arena().make<BasicBlock>(Name, Parent);
+
+        Parent->add_basic_block(arena_ptr<BasicBlock>(bb, ArenaDeleter<BasicBlock>(true)));
+
+        return bb;
+    }
+
+    void BasicBlock::set_entry_block(bool entry_block)
+    {
+        if (this->entry_block == entry_block)
+            return;
+
+        this->entry_block = entry_block;
+
+        if (parent_function && parent_function->contains(this))
+            parent_function->update_entry_block(entry_block);
+    }
+
+    void BasicBlock::set_start_addr(std::uint64_t start_addr)
+    {
+        if (parent_function && parent_function->contains(this))
+        {
+            parent_function->unindex_address(this);
+            this->start_addr = start_addr;
+            parent_function->index_address(this);
+        }
+        else
+            this->start_addr = start_addr;
+    }
+
+    void BasicBlock::set_end_addr(std::uint64_t end_addr)
+    {
+        if (parent_function && parent_function->contains(this))
+        {
+            parent_function->unindex_address(this);
+            this->end_addr = end_addr;
+            parent_function->index_address(this);
+        }
+        else
+            this->end_addr = end_addr;
+    }
+
+    InstructionSlice BasicBlock::get_instructions() const
+    {
+        static const InstructionBuffer empty;
 
-        return Parent->get_last_bb();
+        if (!parent_function)
+            return {&empty, 0, 0};
+        return {&parent_function->get_instruction_buffer(), inst_begin, inst_end};
+    }
+
+    bool BasicBlock::add_instruction(opcode_t opcode, std::uint64_t address, std::span<const operand_t> operands)
+    {
+        if (!parent_function)
+            return true;
+        return parent_function->append_instruction(this, opcode, address, operands);
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,152 @@
+#include "cfg/BitVector.hpp"
+
+#include <bit>
+#include <cassert>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+using namespace CFG;
+
+namespace
+{
+    using word_t = BitVector::word_t;
+
+#if defined(__AVX2__)
+    /// @brief number of words in an AVX2 register
+    constexpr std::size_t lanes = 4;
+
+    inline __m256i load(const word_t *p)
+    {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+    }
+
+    inline void store(word_t *p, __m256i v)
+    {
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), v);
+    }
+
+    /// @brief bits that differ between the old and new values
+    inline __m256i changes(__m256i old_value, __m256i new_value)
+    {
+        return _mm256_xor_si256(old_value, new_value);
+    }
+#endif
+} // namespace
+
+bool BitVector::simd_enabled()
+{
+#if defined(__AVX2__)
+    return true;
+#else
+    return false;
+#endif
+}
+
+std::size_t BitVector::count() const
+{
+    std::size_t total = 0;
+    for (auto w : words)
+        total += std::popcount(w);
+    return total;
+}
+
+bool BitVector::union_with(const BitVector &other)
+{
+    assert(bits == other.bits && "bit vectors of different size");
+
+    auto dst = words.data();
+    auto src = other.words.data();
+    const auto n = words.size();
+    std::size_t i = 0;
+    word_t changed = 0;
+
+#if defined(__AVX2__)
+    __m256i diff = _mm256_setzero_si256();
+    for (; i + lanes <= n; i += lanes)
+    {
+        auto old_value = load(dst + i);
+        auto new_value = _mm256_or_si256(old_value, load(src + i));
+        diff = _mm256_or_si256(diff, changes(old_value, new_value));
+        store(dst + i, new_value);
+    }
+    changed = !_mm256_testz_si256(diff, diff);
+#endif
+
+    for (; i < n; i++)
+    {
+        auto new_value = dst[i] | src[i];
+        changed |= new_value ^ dst[i];
+        dst[i] = new_value;
+    }
+
+    return changed != 0;
+}
+
+bool BitVector::intersect_with(const BitVector &other)
+{
+    assert(bits == other.bits && "bit vectors of different size");
+
+    auto dst = words.data();
+    auto src = other.words.data();
+    const auto n = words.size();
+    std::size_t i = 0;
+    word_t changed = 0;
+
+#if defined(__AVX2__)
+    __m256i diff = _mm256_setzero_si256();
+    for (; i + lanes <= n; i += lanes)
+    {
+        auto old_value = load(dst + i);
+        auto new_value = _mm256_and_si256(old_value, load(src + i));
+        diff = _mm256_or_si256(diff, changes(old_value, new_value));
+        store(dst + i, new_value);
+    }
+    changed = !_mm256_testz_si256(diff, diff);
+#endif
+
+    for (; i < n; i++)
+    {
+        auto new_value = dst[i] & src[i];
+        changed |= new_value ^ dst[i];
+        dst[i] = new_value;
+    }
+
+    return changed != 0;
+}
+
+bool BitVector::assign_transfer(const BitVector &in, const BitVector &gen, const BitVector &kill)
+{
+    assert(bits == in.bits && bits == gen.bits && bits == kill.bits && "bit vectors of different size");
+
+    auto dst = words.data();
+    auto a = in.words.data();
+    auto g = gen.words.data();
+    auto k = kill.words.data();
+    const auto n = words.size();
+    std::size_t i = 0;
+    word_t changed = 0;
+
+#if defined(__AVX2__)
+    __m256i diff = _mm256_setzero_si256();
+    for (; i + lanes <= n; i += lanes)
+    {
+        auto old_value = load(dst + i);
+        /// andnot computes ~kill & in
+        auto new_value = _mm256_or_si256(load(g + i), _mm256_andnot_si256(load(k + i), load(a + i)));
+        diff = _mm256_or_si256(diff, changes(old_value, new_value));
+        store(dst + i, new_value);
+    }
+    changed = !_mm256_testz_si256(diff, diff);
+#endif
+
+    for (; i < n; i++)
+    {
+        auto new_value = g[i] | (a[i] & ~k[i]);
+        changed |= new_value ^ dst[i];
+        dst[i] = new_value;
+    }
+
+    return changed != 0;
+}
@@ -0,0 +1,33 @@
+#include "cfg/BlockOrder.hpp"
+#include "cfg/Function.hpp"
+#include "cfg/GraphKernel.hpp"
+
+using namespace CFG;
+
+BlockOrder::BlockOrder(const Function &F)
+{
+    auto blocks = F.get_basic_blocks();
+    const std::size_t n = F.get_block_id_bound();
+
+    rpo_index.assign(n, unreached);
+
+    auto entry = std::find_if(blocks.begin(), blocks.end(), [](const Function::block_ptr_t &bb)
+                              { return bb->get_entry_block(); });
+    if (entry == blocks.end())
+        return;
+
+    CSREdges local;
+    const CSREdges *edges = &F.get_csr();
+    if (!F.is_finalized())
+    {
+        F.pack_edges(local);
+        edges = &local;
+    }
+
+    std::vector<bool> visited(n);
+    depth_first_search(CSRGraphView(*edges), (*entry)->get_id(), &preorder, &postorder, visited);
+
+    reverse_postorder.assign(postorder.rbegin(), postorder.rend());
+    for (std::uint32_t i = 0; i < reverse_postorder.size(); i++)
+        rpo_index[reverse_postorder[i]] = i;
+}
@@ -0,0 +1,100 @@
+#include "cfg/CallGraph.hpp"
+#include "cfg/Module.hpp"
+#include "cfg/ThreadPool.hpp"
+
+#include <atomic>
+#include <memory>
+
+using namespace CFG;
+
+CallGraph::CallGraph(const Module &M)
+{
+    const auto n = M.get_function_id_bound();
+
+    /// the ids of deleted functions have no calls
+    offsets.assign(n + 1, 0);
+    for (std::uint32_t i = 0; i < n; i++)
+    {
+        if (auto func = M.get_function(i))
+            for (auto callee : M.get_callees(func))
+                targets.push_back(callee->get_id());
+        offsets[i + 1] = static_cast<std::uint32_t>(targets.size());
+    }
+
+    sccs.compute(offsets, targets);
+}
+
+void CallGraph::run_bottom_up(const Module &M, const std::function<void(Function &)> &task, unsigned threads) const
+{
+    const auto num = static_cast<std::uint32_t>(sccs.num_components());
+
+    auto run_component = [&](std::uint32_t comp)
+    {
+        auto [first, last] = sccs.get_members(comp);
+        for (auto m = first; m != last; ++m)
+            if (auto func = M.get_function(*m))
+                task(*func);
+    };
+
+    /// components are in topological order, from the last one
+    /// the callees always come first
+    if (threads == 1 || num < 2)
+    {
+        for (auto comp = num; comp-- > 0;)
+            run_component(comp);
+        return;
+    }
+
+    /// callers of each component, in CSR form, and number of
+    /// callee components still running or waiting
+    std::vector<std::uint32_t> caller_offsets(num + 1, 0);
+    std::vector<std::uint32_t> caller_list;
+    std::unique_ptr<std::atomic<std::uint32_t>[]> waiting(new std::atomic<std::uint32_t>[num]);
+
+    for (std::uint32_t comp = 0; comp < num; comp++)
+    {
+        auto [first, last] = sccs.get_successors(comp);
+        waiting[comp].store(static_cast<std::uint32_t>(last - first), std::memory_order_relaxed);
+        for (auto callee = first; callee != last; ++callee)
+            caller_offsets[*callee + 1]++;
+    }
+    for (std::uint32_t comp = 0; comp < num; comp++)
+        caller_offsets[comp + 1] += caller_offsets[comp];
+
+    caller_list.resize(caller_offsets[num]);
+    {
+        std::vector<std::uint32_t> cursor(caller_offsets.begin(), caller_offsets.end() - 1);
+        for (std::uint32_t comp = 0; comp < num; comp++)
+        {
+            auto [first, last] = sccs.get_successors(comp);
+            for (auto callee = first; callee != last; ++callee)
+                caller_list[cursor[*callee]++] = comp;
+        }
+    }
+
+    ThreadPool pool(threads);
+
+    /// a finished component queues the callers it was the last
+    /// callee of, in the queue of the same worker
+    std::function<void(std::uint32_t)> schedule = [&](std::uint32_t comp)
+    {
+        pool.submit([&, comp]()
+                    {
+                        run_component(comp);
+                        for (auto i = caller_offsets[comp]; i < caller_offsets[comp + 1]; i++)
+                            if (waiting[caller_list[i]].fetch_sub(1, std::memory_order_acq_rel) == 1)
+                                schedule(caller_list[i]); });
+    };
+
+    /// the leaves are found before queuing any of them, once the tasks
+    /// run the counters of the other components start to drop to 0
+    std::vector<std::uint32_t> leaves;
+    for (std::uint32_t comp = num; comp-- > 0;)
+        if (waiting[comp].load(std::memory_order_relaxed) == 0)
+            leaves.push_back(comp);
+
+    for (auto comp : leaves)
+        schedule(comp);
+
+    pool.wait();
+}
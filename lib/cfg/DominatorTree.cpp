@@ -0,0 +1,311 @@
+#include "cfg/DominatorTree.hpp"
+#include "cfg/Function.hpp"
+
+#include <utility>
+
+using namespace CFG;
+
+namespace
+{
+    /// @brief Adjacency lists in CSR form
+    struct Adjacency
+    {
+        const std::uint32_t *offsets;
+        const block_id_t *targets;
+
+        const block_id_t *begin(block_id_t v) const { return targets + offsets[v]; }
+        const block_id_t *end(block_id_t v) const { return targets + offsets[v + 1]; }
+        std::uint32_t degree(block_id_t v) const { return offsets[v + 1] - offsets[v]; }
+    };
+
+    /// @brief Lengauer-Tarjan with the sophisticated (balanced) link
+    /// and eval, it runs in O(E * alpha(E, V)). Internally the vertices
+    /// are numbered from 1, so 0 can be used as the null vertex.
+    class LengauerTarjan
+    {
+        std::vector<std::uint32_t> parent, semi, vertex, label, ancestor, child, size, dom;
+        std::vector<std::uint32_t> bucket_head, bucket_next;
+        std::vector<std::uint32_t> compress_stack;
+
+        void compress(std::uint32_t v)
+        {
+            /// iterative version of the recursive compress, the deepest
+            /// ancestors have to be updated first
+            compress_stack.clear();
+            while (ancestor[ancestor[v]] != 0)
+            {
+                compress_stack.push_back(v);
+                v = ancestor[v];
+            }
+
+            while (!compress_stack.empty())
+            {
+                v = compress_stack.back();
+                compress_stack.pop_back();
+                auto a = ancestor[v];
+                if (semi[label[a]] < semi[label[v]])
+                    label[v] = label[a];
+                ancestor[v] = ancestor[a];
+            }
+        }
+
+        std::uint32_t eval(std::uint32_t v)
+        {
+            if (ancestor[v] == 0)
+                return label[v];
+            compress(v);
+            return semi[label[ancestor[v]]] >= semi[label[v]] ? label[v] : label[ancestor[v]];
+        }
+
+        void link(std::uint32_t v, std::uint32_t w)
+        {
+            auto s = w;
+            while (semi[label[w]] < semi[label[child[s]]])
+            {
+                if (size[s] + size[child[child[s]]] >= 2 * size[child[s]])
+                {
+                    ancestor[child[s]] = s;
+                    child[s] = child[child[s]];
+                }
+                else
+                {
+                    size[child[s]] = size[s];
+                    s = ancestor[s] = child[s];
+                }
+            }
+            label[s] = label[w];
+            size[v] += size[w];
+            if (size[v] < 2 * size[w])
+                std::swap(s, child[v]);
+            while (s != 0)
+            {
+                ancestor[s] = v;
+                s = child[s];
+            }
+        }
+
+    public:
+        void run(std::size_t n, block_id_t root, Adjacency succ, Adjacency pred, std::vector<block_id_t> &idom)
+        {
+            idom.assign(n, DominatorTree::invalid);
+
+            if (root == DominatorTree::invalid)
+                return;
+
+            for (auto vec : {&parent, &semi, &vertex, &label, &ancestor, &child, &size, &dom, &bucket_head, &bucket_next})
+                vec->assign(n + 1, 0);
+
+            /// depth first search numbering the vertices in preorder
+            std::uint32_t count = 0;
+            std::vector<std::pair<std::uint32_t, const block_id_t *>> stack;
+
+            auto number = [&](std::uint32_t v)
+            {
+                semi[v] = ++count;
+                vertex[count] = v;
+                label[v] = v;
+                size[v] = 1;
+                stack.emplace_back(v, succ.begin(v - 1));
+            };
+
+            number(root + 1);
+
+            while (!stack.empty())
+            {
+                auto &[v, it] = stack.back();
+                if (it == succ.end(v - 1))
+                {
+                    stack.pop_back();
+                    continue;
+                }
+                auto w = *it++ + 1;
+                if (semi[w] == 0)
+                {
+                    parent[w] = v;
+                    number(w);
+                }
+            }
+
+            for (auto i = count; i >= 2; i--)
+            {
+                auto w = vertex[i];
+
+                for (auto p = pred.begin(w - 1); p != pred.end(w - 1); ++p)
+                {
+                    auto v = *p + 1;
+                    /// predecessors not reached by the search are ignored
+                    if (semi[v] == 0)
+                        continue;
+                    auto u = eval(v);
+                    if (semi[u] < semi[w])
+                        semi[w] = semi[u];
+                }
+
+                auto b = vertex[semi[w]];
+                bucket_next[w] = bucket_head[b];
+                bucket_head[b] = w;
+
+                link(parent[w], w);
+
+                for (auto v = bucket_head[parent[w]]; v != 0; v = bucket_next[v])
+                {
+                    auto u = eval(v);
+                    dom[v] = semi[u] < semi[v] ? u : parent[w];
+                }
+                bucket_head[parent[w]] = 0;
+            }
+
+            for (std::uint32_t i = 2; i <= count; i++)
+            {
+                auto w = vertex[i];
+                if (dom[w] != vertex[semi[w]])
+                    dom[w] = dom[dom[w]];
+                idom[w - 1] = dom[w] - 1;
+            }
+        }
+    };
+} // namespace
+
+DominatorTree::DominatorTree(const Function &F, bool post) : post(post)
+{
+    CSREdges local;
+    const CSREdges *edges = &F.get_csr();
+    if (!F.is_finalized())
+    {
+        F.pack_edges(local);
+        edges = &local;
+    }
+
+    auto blocks = F.get_basic_blocks();
+    const std::size_t n = F.get_block_id_bound();
+
+    /// graph analyzed, the function graph or its reverse
+    std::vector<std::uint32_t> succ_offsets, pred_offsets;
+    std::vector<block_id_t> succ_targets, pred_targets;
+    Adjacency succ, pred;
+    std::size_t nodes = n;
+
+    if (!post)
+    {
+        for (const auto &bb : blocks)
+        {
+            if (bb->get_entry_block())
+            {
+                root = bb->get_id();
+                break;
+            }
+        }
+
+        succ = {edges->succ_offsets.data(), edges->succ_targets.data()};
+        pred = {edges->pred_offsets.data(), edges->pred_sources.data()};
+    }
+    else
+    {
+        /// virtual exit with id n, the sucessors of a block in the reverse
+        /// graph are its predecessors, and the exit goes to every block
+        /// without sucessors, the ids of deleted blocks are left alone
+        nodes = n + 1;
+        root = static_cast<block_id_t>(n);
+
+        Adjacency fwd_succ{edges->succ_offsets.data(), edges->succ_targets.data()};
+        Adjacency fwd_pred{edges->pred_offsets.data(), edges->pred_sources.data()};
+
+        succ_offsets.reserve(nodes + 1);
+        pred_offsets.reserve(nodes + 1);
+        succ_offsets.push_back(0);
+        pred_offsets.push_back(0);
+
+        for (block_id_t v = 0; v < n; v++)
+        {
+            succ_targets.insert(succ_targets.end(), fwd_pred.begin(v), fwd_pred.end(v));
+            succ_offsets.push_back(static_cast<std::uint32_t>(succ_targets.size()));
+
+            pred_targets.insert(pred_targets.end(), fwd_succ.begin(v), fwd_succ.end(v));
+            if (fwd_succ.degree(v) == 0 && F.get_basic_block(v))
+                pred_targets.push_back(root);
+            pred_offsets.push_back(static_cast<std::uint32_t>(pred_targets.size()));
+        }
+
+        for (block_id_t v = 0; v < n; v++)
+            if (fwd_succ.degree(v) == 0 && F.get_basic_block(v))
+                succ_targets.push_back(v);
+        succ_offsets.push_back(static_cast<std::uint32_t>(succ_targets.size()));
+        pred_offsets.push_back(static_cast<std::uint32_t>(pred_targets.size()));
+
+        succ = {succ_offsets.data(), succ_targets.data()};
+        pred = {pred_offsets.data(), pred_targets.data()};
+    }
+
+    LengauerTarjan().run(nodes, root, succ, pred, idom);
+
+    /// children of every block, in CSR form
+    children_offsets.assign(nodes + 1, 0);
+    for (block_id_t v = 0; v < nodes; v++)
+        if (idom[v] != invalid)
+            children_offsets[idom[v] + 1]++;
+    for (std::size_t v = 0; v < nodes; v++)
+        children_offsets[v + 1] += children_offsets[v];
+    children.resize(children_offsets[nodes]);
+    {
+        std::vector<std::uint32_t> cursor(children_offsets.begin(), children_offsets.end() - 1);
+        for (block_id_t v = 0; v < nodes; v++)
+            if (idom[v] != invalid)
+                children[cursor[idom[v]]++] = v;
+    }
+
+    /// number the tree in preorder and postorder, a dominates b
+    /// if the interval of b is inside the interval of a
+    pre.assign(nodes, 0);
+    post_number.assign(nodes, 0);
+    if (root != invalid)
+    {
+        std::uint32_t pre_count = 0, post_count = 0;
+        std::vector<std::pair<block_id_t, std::uint32_t>> stack;
+        stack.emplace_back(root, children_offsets[root]);
+        pre[root] = pre_count++;
+
+        while (!stack.empty())
+        {
+            auto &[v, it] = stack.back();
+            if (it == children_offsets[v + 1])
+            {
+                post_number[v] = post_count++;
+                stack.pop_back();
+                continue;
+            }
+            auto c = children[it++];
+            pre[c] = pre_count++;
+            stack.emplace_back(c, children_offsets[c]);
+        }
+    }
+
+    /// dominance frontiers (Cooper, Harvey and Kennedy), only the join
+    /// points contribute, walking up from each predecessor to the idom;
+    /// the root has no edge from outside, so any back edge into it
+    /// already makes it a join point
+    std::vector<std::vector<block_id_t>> df(nodes);
+    for (block_id_t b = 0; b < nodes; b++)
+    {
+        if (!is_reachable(b) || pred.degree(b) < (b == root ? 1u : 2u))
+            continue;
+
+        for (auto p = pred.begin(b); p != pred.end(b); ++p)
+        {
+            if (!is_reachable(*p))
+                continue;
+            for (auto runner = *p; runner != idom[b] && runner != invalid; runner = idom[runner])
+            {
+                if (!df[runner].empty() && df[runner].back() == b)
+                    break;
+                df[runner].push_back(b);
+            }
+        }
+    }
+
+    frontier_offsets.assign(nodes + 1, 0);
+    for (block_id_t v = 0; v < nodes; v++)
+    {
+        frontier_offsets[v + 1] = frontier_offsets[v] + static_cast<std::uint32_t>(df[v].size());
+        frontier.insert(frontier.end(), df[v].begin(), df[v].end());
+    }
+}
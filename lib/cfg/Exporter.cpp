@@ -0,0 +1,316 @@
+#include "cfg/Exporter.hpp"
+#include "cfg/Module.hpp"
+#include "cfg/ThreadPool.hpp"
+
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+#include <utility>
+
+using namespace CFG;
+
+FileSink::FileSink(const std::string &path) : file(std::fopen(path.c_str(), "wb"))
+{
+    if (file == nullptr)
+        throw exceptions::SerializationException("Cannot open " + path + " for writing: " + std::strerror(errno));
+}
+
+FileSink::~FileSink()
+{
+    if (file)
+        std::fclose(file);
+}
+
+void FileSink::write(const char *data, std::size_t size)
+{
+    if (std::fwrite(data, 1, size, file) != size)
+        throw exceptions::SerializationException("Error writing exported graph");
+}
+
+void FileSink::close()
+{
+    auto closing = std::exchange(file, nullptr);
+    if (closing && std::fclose(closing) != 0)
+        throw exceptions::SerializationException(std::string("Error closing exported graph: ") + std::strerror(errno));
+}
+
+OutputBuffer &OutputBuffer::write_escaped(std::string_view str)
+{
+    static constexpr char hex[] = "0123456789abcdef";
+
+    for (auto c : str)
+    {
+        switch (c)
+        {
+        case '"':
+            write("\\\"");
+            break;
+        case '\\':
+            write("\\\\");
+            break;
+        case '\n':
+            write("\\n");
+            break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20)
+            {
+                write("\\u00");
+                write(hex[(c >> 4) & 0xf]);
+                write(hex[c & 0xf]);
+            }
+            else
+                write(c);
+        }
+    }
+    return *this;
+}
+
+OutputBuffer &OutputBuffer::write_dot_escaped(std::string_view str)
+{
+    for (auto c : str)
+    {
+        switch (c)
+        {
+        case '"':
+            write("\\\"");
+            break;
+        case '\\':
+            write("\\\\");
+            break;
+        case '\n':
+            write("\\n");
+            break;
+        default:
+            write(static_cast<unsigned char>(c) < 0x20 ? ' ' : c);
+        }
+    }
+    return *this;
+}
+
+namespace
+{
+    /// @brief Get the packed edges of a function, the scratch memory of
+    /// every thread is reused between functions. With `dense` the blocks
+    /// are numbered by their position, so the ids written have no gaps
+    /// when some blocks were deleted, a finalized function already has them
+    const CSREdges &get_edges(const Function &F, bool dense)
+    {
+        if (F.is_finalized())
+            return F.get_csr();
+
+        static thread_local CSREdges scratch;
+        F.pack_edges(scratch, dense);
+        return scratch;
+    }
+
+    void export_dot(const Function &F, const CSREdges &edges, OutputBuffer &out)
+    {
+        auto blocks = F.get_basic_blocks();
+
+        out.write("digraph ").write_dot_quoted(F.get_name()).write("{\n");
+        out.write("style=\"dashed\";\n");
+        out.write("color=\"black\";\n");
+        out.write("label=").write_dot_quoted(F.get_name()).write(";\n");
+
+        for (const auto &bb : blocks)
+        {
+            out.write_dot_quoted(bb->get_name());
+            out.write(" [shape=box, style=filled, fillcolor=lightgrey, label=\"BB-");
+            out.write_dot_escaped(bb->get_name()).write("\"];\n\n");
+        }
+
+        for (block_id_t src = 0; src < edges.num_blocks(); src++)
+        {
+            for (auto e = edges.succ_begin(src); e < edges.succ_end(src); e++)
+            {
+                out.write_dot_quoted(F.get_basic_block(src)->get_name()).write(" -> ");
+                out.write_dot_quoted(F.get_basic_block(edges.succ_targets[e])->get_name());
+                out.write(" [style=\"solid,bold\",color=black,weight=10,constraint=true,label=");
+                out.write_dot_quoted(edges.tags.get(edges.succ_tags[e])).write("];\n");
+            }
+        }
+
+        out.write("}");
+    }
+
+    void export_json(const Function &F, const CSREdges &edges, OutputBuffer &out)
+    {
+        out.write("{\"name\":").write_quoted(F.get_name()).write(",\"blocks\":[");
+
+        block_id_t id = 0;
+        for (const auto &bb : F.get_basic_blocks())
+        {
+            if (id)
+                out.write(',');
+            out.write("{\"id\":").write_uint(id++);
+            out.write(",\"name\":").write_quoted(bb->get_name());
+            out.write(",\"start\":").write_uint(bb->get_start_addr());
+            out.write(",\"end\":").write_uint(bb->get_end_addr());
+            out.write(",\"entry\":").write(bb->get_entry_block() ? "true" : "false").write('}');
+        }
+
+        out.write("],\"edges\":[");
+
+        bool first = true;
+        for (block_id_t src = 0; src < edges.num_blocks(); src++)
+        {
+            for (auto e = edges.succ_begin(src); e < edges.succ_end(src); e++)
+            {
+                if (!first)
+                    out.write(',');
+                first = false;
+                out.write('[').write_uint(src).write(',').write_uint(edges.succ_targets[e]).write(',');
+                out.write_quoted(edges.tags.get(edges.succ_tags[e])).write(']');
+            }
+        }
+
+        out.write("]}");
+    }
+
+    void export_edge_list(const Function &F, const CSREdges &edges, OutputBuffer &out)
+    {
+        out.write("function ").write_quoted(F.get_name()).write('\n');
+
+        block_id_t id = 0;
+        for (const auto &bb : F.get_basic_blocks())
+        {
+            out.write("block ").write_uint(id++).write(' ').write_quoted(bb->get_name());
+            out.write(" 0x").write_uint(bb->get_start_addr(), 16);
+            out.write(" 0x").write_uint(bb->get_end_addr(), 16);
+            if (bb->get_entry_block())
+                out.write(" entry");
+            out.write('\n');
+        }
+
+        for (block_id_t src = 0; src < edges.num_blocks(); src++)
+        {
+            for (auto e = edges.succ_begin(src); e < edges.succ_end(src); e++)
+            {
+                out.write("edge ").write_uint(src).write(' ').write_uint(edges.succ_targets[e]).write(' ');
+                out.write_quoted(edges.tags.get(edges.succ_tags[e])).write('\n');
+            }
+        }
+
+        out.write("end\n");
+    }
+
+    const char *extension(ExportFormat format)
+    {
+        switch (format)
+        {
+        case ExportFormat::Dot:
+            return ".dot";
+        case ExportFormat::Json:
+            return ".json";
+        default:
+            return ".cfg";
+        }
+    }
+} // namespace
+
+void CFG::export_function(const Function &F, OutputBuffer &out, ExportFormat format)
+{
+    /// DOT names the blocks, the other formats number them
+    const auto &edges = get_edges(F, format != ExportFormat::Dot);
+
+    switch (format)
+    {
+    case ExportFormat::Dot:
+        export_dot(F, edges, out);
+        break;
+    case ExportFormat::Json:
+        export_json(F, edges, out);
+        break;
+    case ExportFormat::EdgeList:
+        export_edge_list(F, edges, out);
+        break;
+    }
+}
+
+void CFG::export_module(const Module &M, OutputBuffer &out, ExportFormat format)
+{
+    auto functions = M.get_functions();
+
+    switch (format)
+    {
+    case ExportFormat::Dot:
+        for (const auto &func : functions)
+        {
+            export_function(*func, out, format);
+            out.write('\n');
+        }
+        break;
+    case ExportFormat::Json:
+        out.write("{\"module\":").write_quoted(M.get_name()).write(",\"functions\":[");
+        for (auto it = functions.begin(); it != functions.end(); ++it)
+        {
+            if (it != functions.begin())
+                out.write(',');
+            export_function(**it, out, format);
+        }
+        out.write("]}\n");
+        break;
+    case ExportFormat::EdgeList:
+        out.write("module ").write_quoted(M.get_name()).write('\n');
+        for (const auto &func : functions)
+            export_function(*func, out, format);
+        break;
+    }
+
+    out.flush();
+}
+
+void CFG::export_module_split(const Module &M, const std::string &directory, ExportFormat format, unsigned threads)
+{
+    /// the files are numbered by the position of the functions
+    std::vector<const Function *> functions;
+    functions.reserve(M.get_num_functions());
+    for (const auto &func : M.get_functions())
+        functions.push_back(func.get());
+
+    auto export_one = [&](std::size_t i)
+    {
+        /// names are reduced to characters safe for a file name
+        std::string path = directory + "/" + std::to_string(i) + "-";
+        for (auto c : functions[i]->get_name())
+            path += (std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '.') ? c : '_';
+        path += extension(format);
+
+        FileSink sink(path);
+        OutputBuffer out(sink, 64 * 1024);
+        export_function(*functions[i], out, format);
+        if (format != ExportFormat::EdgeList)
+            out.write('\n');
+        out.flush();
+        sink.close();
+    };
+
+    if (threads == 1 || functions.size() < 2)
+    {
+        for (std::size_t i = 0; i < functions.size(); i++)
+            export_one(i);
+        return;
+    }
+
+    /// the first error of the workers is given back to the caller
+    std::mutex error_lock;
+    std::string error;
+
+    ThreadPool pool(threads);
+    pool.parallel_for(functions.size(), [&](std::size_t i)
+                      {
+                          try
+                          {
+                              export_one(i);
+                          }
+                          catch (std::exception &e)
+                          {
+                              std::lock_guard<std::mutex> guard(error_lock);
+                              if (error.empty())
+                                  error = e.what();
+                          } });
+
+    if (!error.empty())
+        throw exceptions::SerializationException(error);
+}
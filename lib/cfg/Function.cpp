@@ -1,13 +1,671 @@
 #include "cfg/Function.hpp"
 #include "cfg/Module.hpp"
+#include "cfg/Exporter.hpp"
 
 using namespace CFG;
 
+Function::Function(std::string_view Name, Module *Parent)
+    : own_arena(Parent ? nullptr : std::make_unique<Arena>()),
+      arena(Parent ? &Parent->get_arena() : own_arena.get()),
+      name(arena->intern(Name)),
+      parent_module(Parent)
+{
+}
+
+Function::Function(std::string_view Name, Module *Parent, Arena &Storage)
+    : arena(&Storage),
+      name(arena->intern(Name)),
+      parent_module(Parent)
+{
+}
+
 Function *Function::Create(std::string_view Name, Module *Parent)
 {
     assert(Parent && "Parent Module must be specified");
 
-    Parent->add_function(std::make_unique<Function>(Name, Parent));
+    auto func = Parent->get_arena().make<Function>(Name, Parent);
+
+    Parent->add_function(arena_ptr<Function>(func, ArenaDeleter<Function>(true)));
+
+    return func;
+}
+void Function::pack_edges(CSREdges &out, bool dense) const
+{
+    if (finalized)
+    {
+        out = csr;
+        return;
+    }
+
+    /// position of every block among the blocks of the function, only
+    /// needed when there are empty slots and the result is dense
+    std::vector<block_id_t> position;
+    if (dense && block_count != basic_blocks.size())
+    {
+        position.assign(basic_blocks.size(), 0);
+        block_id_t next = 0;
+        for (const auto &bb : get_basic_blocks())
+            position[bb->get_id()] = next++;
+    }
+    else
+        dense = false;
+
+    auto index = [&](block_id_t id)
+    { return dense ? position[id] : id; };
+
+    const auto n = dense ? block_count : basic_blocks.size();
+
+    out.clear();
+    out.succ_offsets.assign(n + 1, 0);
+    out.pred_offsets.assign(n + 1, 0);
+
+    /// first pass, count the edges of each block
+    for (const auto &bb : get_basic_blocks())
+    {
+        const auto &succs = bb->succ_edges;
+
+        out.succ_offsets[index(bb->get_id()) + 1] = succs.size();
+        for (const auto &succ : succs)
+            out.pred_offsets[index(succ.target->get_id()) + 1]++;
+    }
+
+    for (std::size_t i = 0; i < n; i++)
+    {
+        out.succ_offsets[i + 1] += out.succ_offsets[i];
+        out.pred_offsets[i + 1] += out.pred_offsets[i];
+    }
+
+    out.succ_targets.resize(out.succ_offsets[n]);
+    out.succ_tags.resize(out.succ_offsets[n]);
+    out.pred_sources.resize(out.pred_offsets[n]);
+
+    /// second pass, place the edges, the predecessors are written
+    /// in order of source block so the result is deterministic
+    std::vector<std::uint32_t> pred_cursor(out.pred_offsets.begin(), out.pred_offsets.end() - 1);
+
+    for (const auto &bb : get_basic_blocks())
+    {
+        auto src = index(bb->get_id());
+        auto cursor = out.succ_offsets[src];
+
+        for (const auto &succ : bb->succ_edges)
+        {
+            auto dst = index(succ.target->get_id());
+            out.succ_targets[cursor] = dst;
+            out.succ_tags[cursor] = out.tags.intern(arena->get_tag(succ.tag));
+            cursor++;
+            out.pred_sources[pred_cursor[dst]++] = src;
+        }
+    }
+}
+
+std::size_t Function::get_edge_bytes() const
+{
+    std::size_t bytes = csr.succ_offsets.capacity() * sizeof(std::uint32_t) +
+                        csr.succ_targets.capacity() * sizeof(block_id_t) +
+                        csr.succ_tags.capacity() * sizeof(tag_id_t) +
+                        csr.pred_offsets.capacity() * sizeof(std::uint32_t) +
+                        csr.pred_sources.capacity() * sizeof(block_id_t);
+
+    for (const auto &bb : get_basic_blocks())
+        bytes += bb->succ_edges.heap_bytes() + bb->pred_edges.heap_bytes();
+
+    return bytes;
+}
+
+void Function::finalize()
+{
+    if (finalized)
+        return;
+
+    compact();
+    pack_edges(csr);
+
+    /// release the memory of the mutable representation
+    for (const auto &bb : get_basic_blocks())
+    {
+        bb->succ_edges.reset();
+        bb->pred_edges.reset();
+    }
+
+    finalized = true;
+}
+
+void Function::compact()
+{
+    if (block_count == basic_blocks.size())
+        return;
+
+    invalidate_analyses();
+
+    block_id_t next = 0;
+    for (block_id_t id = 0; id < basic_blocks.size(); id++)
+    {
+        if (!basic_blocks[id])
+            continue;
+
+        if (id != next)
+        {
+            basic_blocks[next] = std::move(basic_blocks[id]);
+            basic_blocks[next]->id = next;
+            reachable[next] = reachable[id];
+            if (on_block_remap)
+                on_block_remap(id, next);
+        }
+        next++;
+    }
+
+    basic_blocks.resize(next);
+    reachable.resize(next);
+}
+
+void Function::thaw()
+{
+    if (!finalized)
+        return;
+
+    for (block_id_t src = 0; src < csr.num_blocks(); src++)
+    {
+        auto src_bb = basic_blocks[src].get();
+
+        for (auto e = csr.succ_begin(src); e < csr.succ_end(src); e++)
+        {
+            auto dst_bb = basic_blocks[csr.succ_targets[e]].get();
+            link(src_bb, dst_bb, arena->intern_tag(csr.tags.get(csr.succ_tags[e])));
+        }
+    }
+
+    csr.clear();
+
+    finalized = false;
+}
+
+bool Function::add_successors(std::span<const Edge> edges)
+{
+    CFG_STATS_SCOPE(AddSuccessors);
+
+    /// sucessors searched linearly for a duplicate, as add_sucessor does,
+    /// the edges of sources with more sucessors are sorted instead
+    constexpr std::uint32_t linear_search_edges = 8;
+    /// tag of each edge that is added, `none` for the rest
+    constexpr tag_id_t none = ~tag_id_t(0);
+
+    bool skipped = false;
+
+    thaw();
+
+    /// everything is sized by the batch, not by the function, so a lifter
+    /// adding a few edges per discovered block does not pay for the graph
+    std::vector<tag_id_t> kept_tag(edges.size(), none);
+    /// (source id, tag id) and position of the edges of the wide sources
+    std::vector<std::pair<std::uint64_t, std::uint32_t>> wide;
+    std::size_t added = 0;
+
+    /// every tag is interned once, the edges of the sources with few
+    /// sucessors are added right away. Once a source reaches the limit it
+    /// stays there, so its later edges are all sorted and its sucessors
+    /// still come in the order of the span
+    for (std::uint32_t i = 0; i < edges.size(); i++)
+    {
+        const auto &edge = edges[i];
+        if (!contains(edge.src) || !contains(edge.dst))
+        {
+            skipped = true;
+            continue;
+        }
+
+        auto tag = arena->intern_tag(edge.tag);
+        const auto &succs = edge.src->succ_edges;
+
+        if (succs.size() >= linear_search_edges)
+        {
+            wide.emplace_back(std::uint64_t(edge.src->get_id()) << 32 | tag, i);
+            continue;
+        }
+
+        if (std::any_of(succs.begin(), succs.end(), [=](const succ_edge_t &succ)
+                        { return succ.tag == tag; }))
+        {
+            skipped = true;
+            continue;
+        }
+
+        link(edge.src, edge.dst, tag);
+        kept_tag[i] = tag;
+        added++;
+    }
+
+    /// the edges of the wide sources sorted by source, tag and position,
+    /// the first edge of each (source, tag) pair is the one kept
+    std::sort(wide.begin(), wide.end());
+
+    std::vector<tag_id_t> existing;
+    std::vector<std::uint32_t> wide_kept;
+
+    for (std::size_t i = 0; i < wide.size();)
+    {
+        auto src = edges[wide[i].second].src;
+        auto src_id = wide[i].first >> 32;
+
+        /// tags already used by the source
+        existing.clear();
+        for (const auto &succ : src->succ_edges)
+            existing.push_back(succ.tag);
+        std::sort(existing.begin(), existing.end());
+
+        std::uint32_t new_succs = 0;
+        for (; i < wide.size() && wide[i].first >> 32 == src_id; i++)
+        {
+            auto tag = static_cast<tag_id_t>(wide[i].first);
+            bool duplicated = (i > 0 && wide[i - 1].first == wide[i].first) ||
+                              std::binary_search(existing.begin(), existing.end(), tag);
+            if (duplicated)
+            {
+                skipped = true;
+                continue;
+            }
+
+            kept_tag[wide[i].second] = tag;
+            wide_kept.push_back(wide[i].second);
+            new_succs++;
+        }
+
+        /// the sucessors are grown once per source
+        if (new_succs)
+            src->succ_edges.reserve(src->succ_edges.size() + new_succs);
+    }
+
+    /// back to the order of the span
+    std::sort(wide_kept.begin(), wide_kept.end());
+    for (auto i : wide_kept)
+        link(edges[i].src, edges[i].dst, kept_tag[i]);
+    added += wide_kept.size();
+
+    if (!added)
+        return skipped;
+
+    invalidate_analyses();
+
+    /// the reachability is updated once every edge is in place
+    if (reachability_valid)
+        for (std::size_t i = 0; i < edges.size(); i++)
+            if (kept_tag[i] != none && reachable[edges[i].src->get_id()] && !reachable[edges[i].dst->get_id()])
+                propagate_reachability(edges[i].dst->get_id());
+
+    return skipped;
+}
+
+bool Function::add_call(BasicBlock *bb, Function *callee)
+{
+    if (!contains(bb) || !parent_module || !parent_module->contains(this) || !parent_module->contains(callee))
+        return true;
+
+    auto &calls = call_sites[bb];
+    if (std::find(calls.begin(), calls.end(), callee) != calls.end())
+        return true;
+
+    calls.push_back(callee);
+    /// the module already has the call if another block makes it
+    if (callee_blocks[callee]++ == 0)
+        parent_module->add_call(this, callee);
+    return false;
+}
+
+const std::vector<Function *> &Function::get_calls(const BasicBlock *bb) const
+{
+    static const std::vector<Function *> none;
+    auto it = call_sites.find(bb);
+    return it != call_sites.end() ? it->second : none;
+}
+
+void Function::drop_call_sites(const BasicBlock *bb)
+{
+    auto it = call_sites.find(bb);
+    if (it == call_sites.end())
+        return;
+
+    auto callees = std::move(it->second);
+    call_sites.erase(it);
+
+    for (auto callee : callees)
+    {
+        auto count = callee_blocks.find(callee);
+        if (--count->second == 0)
+        {
+            callee_blocks.erase(count);
+            if (parent_module)
+                parent_module->delete_call(this, callee);
+        }
+    }
+}
+
+void Function::move_call_sites(const BasicBlock *b, const BasicBlock *a)
+{
+    auto it = call_sites.find(b);
+    if (it == call_sites.end())
+        return;
+
+    auto callees = std::move(it->second);
+    call_sites.erase(it);
+
+    /// a call both blocks make now has one block less
+    auto &calls = call_sites[a];
+    for (auto callee : callees)
+    {
+        if (std::find(calls.begin(), calls.end(), callee) == calls.end())
+            calls.push_back(callee);
+        else
+            callee_blocks[callee]--;
+    }
+}
+
+void Function::drop_calls_to(const Function *callee)
+{
+    if (!callee_blocks.erase(callee))
+        return;
+
+    for (auto it = call_sites.begin(); it != call_sites.end();)
+    {
+        auto &calls = it->second;
+        calls.erase(std::remove(calls.begin(), calls.end(), callee), calls.end());
+        if (calls.empty())
+            it = call_sites.erase(it);
+        else
+            ++it;
+    }
+}
+
+BasicBlock *Function::split_block(BasicBlock *bb, std::uint64_t addr, std::string_view name)
+{
+    if (!contains(bb) || addr <= bb->get_start_addr() || addr >= bb->get_end_addr())
+        return nullptr;
+
+    auto tail = BasicBlock::Create(name, this);
+    auto end = bb->get_end_addr();
+    bb->set_end_addr(addr);
+    tail->set_start_addr(addr);
+    tail->set_end_addr(end);
+    tail->exit_block = bb->exit_block;
+    bb->exit_block = false;
+
+    /// the instructions from the address on are the slice of the new block
+    auto split = instructions.lower_bound(bb->inst_begin, bb->inst_end, addr);
+    tail->inst_begin = split;
+    tail->inst_end = bb->inst_end;
+    bb->inst_end = split;
+
+    move_sucessors(bb, tail);
+    link(bb, tail, arena->intern_tag("fallthrough"));
+
+    /// the blocks reachable before are still reachable, and
+    /// the new block is reachable if the split one is
+    if (reachability_valid && reachable[bb->get_id()])
+    {
+        reachable[tail->get_id()] = true;
+        reachable_count++;
+    }
+
+    return tail;
+}
+
+bool Function::merge_blocks(BasicBlock *a, BasicBlock *b)
+{
+    if (!contains(a) || !contains(b))
+        return true;
+
+    thaw();
+
+    if (chain_sucessor(a) != b)
+        return true;
+
+    invalidate_analyses();
+
+    unlink(a, 0);
+    move_sucessors(b, a);
+
+    if (a->get_end_addr() == b->get_start_addr())
+        a->set_end_addr(b->get_end_addr());
+    a->exit_block = b->exit_block;
+
+    /// the slice of `b` is taken as is when it follows the one of `a`,
+    /// otherwise it is copied after `a`, moving `a` to the end of the
+    /// buffer first, so a chain merged into its head copies each slice once
+    const auto a_count = a->inst_end - a->inst_begin, b_count = b->inst_end - b->inst_begin;
+    if (b_count)
+    {
+        if (a_count == 0 || a->inst_end == b->inst_begin)
+        {
+            if (a_count == 0)
+                a->inst_begin = b->inst_begin;
+            a->inst_end = b->inst_end;
+            b->inst_begin = b->inst_end = 0;
+        }
+        else
+        {
+            if (a->inst_end != instructions.size())
+            {
+                a->inst_begin = instructions.append(instructions, a->inst_begin, a->inst_end);
+                a->inst_end = a->inst_begin + a_count;
+                dead_instructions += a_count;
+            }
+            instructions.append(instructions, b->inst_begin, b->inst_end);
+            a->inst_end += b_count;
+        }
+    }
+
+    move_call_sites(b, a);
+
+    /// `b` has no edges left, removing it does not change the reachability
+    /// of the other blocks
+    remove_basic_block(b->get_id());
+
+    if (dead_instructions > instructions.size() / 2)
+        compact_instructions();
+
+    return false;
+}
+
+std::size_t Function::collapse_chains()
+{
+    thaw();
+
+    /// the heads of the chains are the blocks that are not merged into their
+    /// predecessor, merging keeps the edges of the rest of the blocks, so
+    /// the heads are found before modifying anything
+    std::vector<BasicBlock *> heads;
+    for (const auto &bb : get_basic_blocks())
+    {
+        const auto &preds = bb->pred_edges;
+        if (preds.size() != 1 || chain_sucessor(preds[0].source) != bb.get())
+            heads.push_back(bb.get());
+    }
+
+    std::size_t merged = 0;
+    for (auto head : heads)
+        for (auto next = chain_sucessor(head); next; next = chain_sucessor(head))
+        {
+            merge_blocks(head, next);
+            merged++;
+        }
+
+    return merged;
+}
+
+bool Function::append_instruction(BasicBlock *bb, opcode_t opcode, std::uint64_t address, std::span<const operand_t> operands)
+{
+    if (!contains(bb))
+        return true;
+
+    const auto count = bb->inst_end - bb->inst_begin;
+
+    if (count == 0)
+        bb->inst_begin = bb->inst_end = instructions.size();
+    else if (bb->inst_end != instructions.size())
+    {
+        bb->inst_begin = instructions.append(instructions, bb->inst_begin, bb->inst_end);
+        bb->inst_end = bb->inst_begin + count;
+        dead_instructions += count;
+    }
+
+    instructions.append(opcode, address, operands);
+    bb->inst_end++;
+
+    if (dead_instructions > instructions.size() / 2)
+        compact_instructions();
+
+    return false;
+}
+
+void Function::compact_instructions()
+{
+    if (dead_instructions == 0)
+        return;
+
+    InstructionBuffer packed;
+    for (const auto &bb : get_basic_blocks())
+    {
+        auto count = bb->inst_end - bb->inst_begin;
+        bb->inst_begin = packed.append(instructions, bb->inst_begin, bb->inst_end);
+        bb->inst_end = bb->inst_begin + count;
+    }
+
+    instructions.swap(packed);
+    dead_instructions = 0;
+}
+
+std::size_t Function::count_reachable(block_id_t entry, ReachabilityContext &context) const
+{
+    /// sucessors are pushed in reverse order, so they
+    /// are visited in the order they were added
+    if (finalized)
+        return context.search(basic_blocks.size(), entry, [this](block_id_t node, auto push)
+                              {
+                                  for (auto e = csr.succ_end(node); e > csr.succ_begin(node); e--)
+                                      push(csr.succ_targets[e - 1]);
+                              });
+
+    return context.search(basic_blocks.size(), entry, [this](block_id_t node, auto push)
+                          {
+                              const auto &succs = basic_blocks[node]->succ_edges;
+                              for (auto i = succs.size(); i > 0; i--)
+                                  push(succs[i - 1].target->get_id());
+                          });
+}
+
+void Function::propagate_reachability(block_id_t from) const
+{
+    if (reachable[from])
+        return;
+
+    reachable[from] = true;
+    reachable_count++;
+    reachability_todo.push_back(from);
+
+    while (!reachability_todo.empty())
+    {
+        auto node = reachability_todo.back();
+        reachability_todo.pop_back();
+
+        for (const auto &succ : basic_blocks[node]->succ_edges)
+        {
+            auto id = succ.target->get_id();
+            if (reachable[id])
+                continue;
+            reachable[id] = true;
+            reachable_count++;
+            reachability_todo.push_back(id);
+        }
+    }
+}
+
+void Function::recheck_reachability(const std::vector<BasicBlock *> &region)
+{
+    std::vector<block_id_t> dirty;
+
+    /// unmark the region that was reachable through the removed block
+    for (auto bb : region)
+    {
+        auto id = bb->get_id();
+        if (!reachable[id])
+            continue;
+        reachable[id] = false;
+        reachable_count--;
+        reachability_todo.push_back(id);
+    }
+
+    while (!reachability_todo.empty())
+    {
+        auto node = reachability_todo.back();
+        reachability_todo.pop_back();
+        dirty.push_back(node);
+
+        for (const auto &succ : basic_blocks[node]->succ_edges)
+        {
+            auto id = succ.target->get_id();
+            if (!reachable[id])
+                continue;
+            reachable[id] = false;
+            reachable_count--;
+            reachability_todo.push_back(id);
+        }
+    }
+
+    /// a block of the region is still reachable if it is the entry or if
+    /// it has a reachable predecessor out of the region, the blocks reachable
+    /// from those are marked again
+    for (auto node : dirty)
+    {
+        if (reachable[node])
+            continue;
+
+        auto bb = basic_blocks[node].get();
+        bool reached = bb == reachability_root;
+
+        if (!reached)
+        {
+            reached = std::any_of(bb->pred_edges.begin(), bb->pred_edges.end(), [this](const pred_edge_t &pred)
+                                  { return reachable[pred.source->get_id()]; });
+        }
+
+        if (reached)
+            propagate_reachability(node);
+    }
+}
+
+void Function::compute_reachability() const
+{
+    auto blocks = get_basic_blocks();
+    auto entry = std::find_if(blocks.begin(), blocks.end(), [](const block_ptr_t &bb)
+                              { return bb->get_entry_block(); });
+
+    reachable.assign(basic_blocks.size(), false);
+    reachable_count = 0;
+
+    if (entry == blocks.end())
+        return;
+
+    auto &context = ReachabilityContext::get();
+    count_reachable((*entry)->get_id(), context);
+
+    for (block_id_t id = 0; id < basic_blocks.size(); id++)
+    {
+        if (context.is_visited(id))
+        {
+            reachable[id] = true;
+            reachable_count++;
+        }
+    }
+
+    reachability_root = entry->get();
+    reachability_valid = true;
+}
+
+void Function::dump_function_dot(std::ofstream &stream) const
+{
+    CFG_STATS_SCOPE(DumpFunctionDot);
 
-    return Parent->get_last_function();
-}
\ No newline at end of file
+    StreamSink sink(stream);
+    OutputBuffer out(sink, 64 * 1024);
+    export_function(*this, out, ExportFormat::Dot);
+    out.flush();
+}
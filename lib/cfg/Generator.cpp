@@ -0,0 +1,237 @@
+#include "cfg/Generator.hpp"
+
+#include <algorithm>
+#include <random>
+
+using namespace CFG;
+
+namespace
+{
+    /// @brief fixed tags, followed by "case 0", "case 1"...
+    enum : std::uint32_t
+    {
+        tag_fallthrough,
+        tag_jump,
+        tag_loop,
+        tag_true,
+        tag_false,
+        tag_first_case,
+    };
+
+    constexpr std::uint32_t max_cases = 64;
+
+    /// @brief Random numbers and the edges of the graph being generated
+    class GraphBuilder
+    {
+        std::mt19937_64 rng;
+
+    public:
+        GeneratedGraph G;
+
+        GraphBuilder(std::size_t num_blocks, std::uint64_t seed) : rng(seed)
+        {
+            G.num_blocks = std::max<std::size_t>(num_blocks, 1);
+            G.tags = {"fallthrough", "jump", "loop", "true", "false"};
+            for (std::uint32_t i = 0; i < max_cases; i++)
+                G.tags.push_back("case " + std::to_string(i));
+        }
+
+        /// @brief random number in [0, n)
+        std::size_t below(std::size_t n) { return rng() % n; }
+
+        void edge(std::size_t src, std::size_t dst, std::uint32_t tag)
+        {
+            G.edges.push_back({static_cast<block_id_t>(src), static_cast<block_id_t>(dst), tag});
+        }
+    };
+
+    void random_dag(GraphBuilder &B)
+    {
+        auto n = B.G.num_blocks;
+        for (std::size_t i = 1; i < n; i++)
+        {
+            B.edge(i - 1, i, tag_fallthrough);
+            if (i + 1 < n && B.below(2) == 0)
+                B.edge(i - 1, i + B.below(n - i), tag_jump);
+        }
+    }
+
+    void loops(GraphBuilder &B)
+    {
+        auto n = B.G.num_blocks;
+        for (std::size_t i = 1; i < n; i++)
+        {
+            B.edge(i - 1, i, tag_fallthrough);
+            /// short back edges to random previous blocks overlap
+            /// and nest with each other
+            if (B.below(4) == 0)
+                B.edge(i, i - 1 - B.below(std::min<std::size_t>(i, 32)), tag_loop);
+            if (i + 1 < n && B.below(8) == 0)
+                B.edge(i - 1, i + B.below(std::min<std::size_t>(n - i, 32)), tag_jump);
+        }
+    }
+
+    void switches(GraphBuilder &B)
+    {
+        auto n = B.G.num_blocks;
+        std::size_t cur = 0;
+        while (cur + 1 < n)
+        {
+            std::size_t cases = 4 + B.below(max_cases - 3);
+            if (cur + cases + 1 >= n)
+            {
+                B.edge(cur, cur + 1, tag_fallthrough);
+                cur++;
+                continue;
+            }
+
+            auto join = cur + cases + 1;
+            for (std::size_t c = 0; c < cases; c++)
+            {
+                B.edge(cur, cur + 1 + c, tag_first_case + c);
+                B.edge(cur + 1 + c, join, tag_fallthrough);
+            }
+            B.edge(cur, join, tag_jump);
+            cur = join;
+        }
+    }
+
+    void compiler(GraphBuilder &B)
+    {
+        auto n = B.G.num_blocks;
+        /// `cur` is the block where the next construct starts, it has no
+        /// sucessors yet, and `next` the first block not used
+        std::size_t cur = 0, next = 1;
+        /// headers of the loops still open, each one keeps a block
+        /// for its exit
+        std::vector<std::size_t> open_loops;
+
+        while (next < n)
+        {
+            auto avail = n - next - open_loops.size();
+
+            if (!open_loops.empty() && (avail == 0 || B.below(10) == 0))
+            {
+                auto header = open_loops.back();
+                open_loops.pop_back();
+                B.edge(cur, header, tag_loop);
+                B.edge(header, next, tag_false);
+                cur = next++;
+                continue;
+            }
+
+            auto r = B.below(100);
+            if (r < 15 && avail >= 2)
+            {
+                /// if-then
+                B.edge(cur, next, tag_true);
+                B.edge(cur, next + 1, tag_false);
+                B.edge(next, next + 1, tag_fallthrough);
+                cur = next + 1;
+                next += 2;
+            }
+            else if (r < 30 && avail >= 3)
+            {
+                /// if-then-else
+                B.edge(cur, next, tag_true);
+                B.edge(cur, next + 1, tag_false);
+                B.edge(next, next + 2, tag_fallthrough);
+                B.edge(next + 1, next + 2, tag_fallthrough);
+                cur = next + 2;
+                next += 3;
+            }
+            else if (r < 45 && avail >= 3)
+            {
+                /// loop header and first block of the body, the
+                /// loop is closed by a later construct
+                B.edge(cur, next, tag_fallthrough);
+                B.edge(next, next + 1, tag_true);
+                open_loops.push_back(next);
+                cur = next + 1;
+                next += 2;
+            }
+            else if (r < 50 && avail >= 4)
+            {
+                /// switch with a few cases
+                auto cases = std::min<std::size_t>(3 + B.below(6), avail - 1);
+                auto join = next + cases;
+                for (std::size_t c = 0; c < cases; c++)
+                {
+                    B.edge(cur, next + c, tag_first_case + c);
+                    B.edge(next + c, join, tag_fallthrough);
+                }
+                cur = join;
+                next = join + 1;
+            }
+            else
+            {
+                B.edge(cur, next, tag_fallthrough);
+                cur = next++;
+            }
+        }
+    }
+} // namespace
+
+std::string_view CFG::shape_name(GraphShape shape)
+{
+    switch (shape)
+    {
+    case GraphShape::RandomDag:
+        return "random-dag";
+    case GraphShape::Loops:
+        return "loops";
+    case GraphShape::Switch:
+        return "switch";
+    case GraphShape::Compiler:
+        return "compiler";
+    }
+    return "unknown";
+}
+
+GeneratedGraph CFG::generate_graph(GraphShape shape, std::size_t num_blocks, std::uint64_t seed)
+{
+    GraphBuilder B(num_blocks, seed);
+
+    switch (shape)
+    {
+    case GraphShape::RandomDag:
+        random_dag(B);
+        break;
+    case GraphShape::Loops:
+        loops(B);
+        break;
+    case GraphShape::Switch:
+        switches(B);
+        break;
+    case GraphShape::Compiler:
+        compiler(B);
+        break;
+    }
+
+    return std::move(B.G);
+}
+
+Function *CFG::build_function(const GeneratedGraph &G, Module *M, std::string_view name)
+{
+    auto Fn = Function::Create(name, M);
+
+    std::vector<BasicBlock *> bbs;
+    bbs.reserve(G.num_blocks);
+    std::string block_name;
+    for (std::size_t i = 0; i < G.num_blocks; i++)
+    {
+        block_name = "bb" + std::to_string(i);
+        auto bb = BasicBlock::Create(block_name, Fn);
+        bb->set_start_addr(0x1000 + 16 * i);
+        bb->set_end_addr(0x1000 + 16 * (i + 1));
+        bbs.push_back(bb);
+    }
+
+    std::vector<Function::Edge> edges;
+    edges.reserve(G.edges.size());
+    for (const auto &edge : G.edges)
+        edges.push_back({bbs[edge.src], bbs[edge.dst], G.get_tag(edge)});
+    Fn->add_successors(edges);
+
+    return Fn;
+}
@@ -0,0 +1,208 @@
+#include "cfg/LoopInfo.hpp"
+#include "cfg/Function.hpp"
+
+using namespace CFG;
+
+LoopInfo::LoopInfo(const Function &F)
+{
+    CSREdges local;
+    const CSREdges *edges = &F.get_csr();
+    if (!F.is_finalized())
+    {
+        F.pack_edges(local);
+        edges = &local;
+    }
+
+    auto blocks = F.get_basic_blocks();
+    const std::size_t n = F.get_block_id_bound();
+
+    block_loop.assign(n, no_loop);
+
+    auto entry = std::find_if(blocks.begin(), blocks.end(), [](const Function::block_ptr_t &bb)
+                              { return bb->get_entry_block(); });
+    if (entry == blocks.end())
+        return;
+
+    constexpr std::uint32_t none = std::numeric_limits<std::uint32_t>::max();
+
+    /// depth first search, the rest of the algorithm works with the
+    /// preorder numbers, `last` is the biggest number in each subtree
+    std::vector<std::uint32_t> number(n, none);
+    std::vector<block_id_t> node;
+    std::vector<std::uint32_t> last;
+    node.reserve(n);
+
+    {
+        std::vector<std::pair<block_id_t, std::uint32_t>> stack;
+        auto visit = [&](block_id_t v)
+        {
+            number[v] = static_cast<std::uint32_t>(node.size());
+            node.push_back(v);
+            stack.emplace_back(v, edges->succ_begin(v));
+        };
+
+        visit((*entry)->get_id());
+        last.resize(n);
+
+        while (!stack.empty())
+        {
+            auto &[v, it] = stack.back();
+            if (it == edges->succ_end(v))
+            {
+                last[number[v]] = static_cast<std::uint32_t>(node.size() - 1);
+                stack.pop_back();
+                continue;
+            }
+            auto w = edges->succ_targets[it++];
+            if (number[w] == none)
+                visit(w);
+        }
+    }
+
+    const auto count = static_cast<std::uint32_t>(node.size());
+
+    auto is_ancestor = [&](std::uint32_t w, std::uint32_t v)
+    {
+        return w <= v && v <= last[w];
+    };
+
+    /// classify the incoming edges of each block
+    std::vector<std::vector<std::uint32_t>> back_preds(count), non_back_preds(count);
+    for (std::uint32_t w = 0; w < count; w++)
+    {
+        auto bb = node[w];
+        for (auto p = edges->pred_begin(bb); p < edges->pred_end(bb); p++)
+        {
+            auto v = number[edges->pred_sources[p]];
+            if (v == none)
+                continue;
+            if (is_ancestor(w, v))
+            {
+                back_preds[w].push_back(v);
+                back_edges.emplace_back(node[v], bb);
+            }
+            else
+                non_back_preds[w].push_back(v);
+        }
+    }
+
+    /// union-find where every collapsed loop body points to its header
+    std::vector<std::uint32_t> uf(count);
+    for (std::uint32_t i = 0; i < count; i++)
+        uf[i] = i;
+
+    auto find = [&](std::uint32_t x)
+    {
+        auto root = x;
+        while (uf[root] != root)
+            root = uf[root];
+        while (uf[x] != root)
+        {
+            auto next = uf[x];
+            uf[x] = root;
+            x = next;
+        }
+        return root;
+    };
+
+    std::vector<std::uint32_t> header(count, none);
+    std::vector<bool> is_header(count, false), irreducible(count, false);
+    std::vector<std::uint32_t> in_body(count, none);
+    /// header whose entries already include each block, so an entry
+    /// reached through several blocks of the region is added once
+    std::vector<std::uint32_t> entry_of(count, none);
+    std::vector<std::uint32_t> body;
+
+    /// from the innermost headers to the outermost ones
+    for (auto w = count; w-- > 0;)
+    {
+        body.clear();
+        bool self_loop = false;
+
+        for (auto v : back_preds[w])
+        {
+            if (v == w)
+            {
+                self_loop = true;
+                continue;
+            }
+            auto x = find(v);
+            if (in_body[x] != w)
+            {
+                in_body[x] = w;
+                body.push_back(x);
+            }
+        }
+
+        /// walk backwards from the sources of the back edges, the bodies
+        /// of the inner loops are already collapsed into their headers
+        for (std::size_t k = 0; k < body.size(); k++)
+        {
+            auto x = body[k];
+            for (auto y : non_back_preds[x])
+            {
+                auto yy = find(y);
+                if (!is_ancestor(w, yy))
+                {
+                    /// entry into the region not through w, it becomes an
+                    /// entry of w for the outer loops
+                    irreducible[w] = true;
+                    if (entry_of[yy] != w)
+                    {
+                        entry_of[yy] = w;
+                        non_back_preds[w].push_back(yy);
+                    }
+                }
+                else if (yy != w && in_body[yy] != w)
+                {
+                    in_body[yy] = w;
+                    body.push_back(yy);
+                }
+            }
+        }
+
+        if (body.empty() && !self_loop)
+            continue;
+
+        is_header[w] = true;
+        for (auto x : body)
+        {
+            header[x] = w;
+            uf[x] = w;
+        }
+    }
+
+    /// build the forest, headers in preorder so parents come first
+    std::vector<std::uint32_t> loop_of(count, no_loop);
+    for (std::uint32_t w = 0; w < count; w++)
+    {
+        if (!is_header[w])
+            continue;
+
+        Loop loop;
+        loop.header = node[w];
+        loop.parent = header[w] == none ? no_loop : loop_of[header[w]];
+        loop.depth = loop.parent == no_loop ? 1 : loops[loop.parent].depth + 1;
+        loop.irreducible = irreducible[w];
+
+        loop_of[w] = static_cast<std::uint32_t>(loops.size());
+        if (loop.parent != no_loop)
+            loops[loop.parent].children.push_back(loop_of[w]);
+        loops.push_back(std::move(loop));
+    }
+
+    for (std::uint32_t x = 0; x < count; x++)
+    {
+        std::uint32_t loop = no_loop;
+        if (is_header[x])
+            loop = loop_of[x];
+        else if (header[x] != none)
+            loop = loop_of[header[x]];
+
+        if (loop == no_loop)
+            continue;
+
+        block_loop[node[x]] = loop;
+        loops[loop].blocks.push_back(node[x]);
+    }
+}
@@ -0,0 +1,94 @@
+#include "cfg/Module.hpp"
+#include "cfg/ThreadPool.hpp"
+
+#include <optional>
+
+using namespace CFG;
+
+void Module::compact()
+{
+    if (function_count == functions.size())
+        return;
+
+    std::uint32_t next = 0;
+    for (std::uint32_t id = 0; id < functions.size(); id++)
+    {
+        if (!functions[id])
+            continue;
+
+        if (id != next)
+        {
+            functions[next] = std::move(functions[id]);
+            functions[next]->id = next;
+            if (on_function_remap)
+                on_function_remap(id, next);
+        }
+        next++;
+    }
+
+    functions.resize(next);
+}
+
+ValidationReport Module::validate_all(unsigned threads) const
+{
+    ValidationReport report;
+    report.functions_checked = function_count;
+
+    /// one slot per function id, so the workers do not need to synchronize
+    std::vector<std::optional<ValidationDiagnostic>> results(functions.size());
+
+    auto validate = [&](std::size_t i)
+    {
+        auto func = functions[i].get();
+        if (!func)
+            return;
+        try
+        {
+            func->validate_function();
+        }
+        catch (exceptions::NoEntryBlockException &e)
+        {
+            results[i] = ValidationDiagnostic{func, ValidationDiagnostic::kind_t::NoEntryBlock, e.what()};
+        }
+        catch (exceptions::MultipleEntryBlockException &e)
+        {
+            results[i] = ValidationDiagnostic{func, ValidationDiagnostic::kind_t::MultipleEntryBlock, e.what()};
+        }
+        catch (exceptions::NoConnectedBlockException &e)
+        {
+            results[i] = ValidationDiagnostic{func, ValidationDiagnostic::kind_t::NoConnectedBlock, e.what()};
+        }
+    };
+
+    if (threads == 1 || functions.size() < 2)
+    {
+        for (std::size_t i = 0; i < functions.size(); i++)
+            validate(i);
+    }
+    else
+    {
+        ThreadPool pool(threads);
+        /// small batches amortize the cost of the tasks while still
+        /// leaving work to steal when the functions are unbalanced
+        auto grain = std::max<std::size_t>(1, functions.size() / (pool.size() * 16));
+        pool.parallel_for(functions.size(), validate, grain);
+    }
+
+    for (auto &result : results)
+        if (result)
+            report.diagnostics.push_back(std::move(*result));
+
+    return report;
+}
+
+namespace CFG
+{
+    std::ostream &operator<<(std::ostream &os, const ValidationReport &report)
+    {
+        os << "Validated " << std::dec << report.functions_checked << " functions, "
+           << report.diagnostics.size() << " errors\n";
+        for (const auto &diag : report.diagnostics)
+            os << "\tFunction-" << diag.function->get_name() << ": " << diag.message << "\n";
+        return os;
+    }
+} // namespace CFG
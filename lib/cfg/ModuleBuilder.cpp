@@ -0,0 +1,81 @@
+#include "cfg/ModuleBuilder.hpp"
+#include "cfg/ThreadPool.hpp"
+
+#include <algorithm>
+#include <atomic>
+
+using namespace CFG;
+
+namespace
+{
+    /// @brief serial numbers of the builders, 0 is never used
+    std::atomic<std::uint64_t> next_serial{1};
+} // namespace
+
+Function *ModuleBuilder::Worker::create_function(std::string_view name, std::uint64_t key)
+{
+    auto func = arena->make<Function>(name, module, *arena);
+    functions.emplace_back(key, Module::function_ptr_t(func, ArenaDeleter<Function>(true)));
+    return func;
+}
+
+ModuleBuilder::ModuleBuilder(Module &M) : module(M), serial(next_serial++)
+{
+}
+
+ModuleBuilder::Worker &ModuleBuilder::get_worker()
+{
+    /// worker of the last builder used by the thread
+    thread_local std::uint64_t cached_serial = 0;
+    thread_local Worker *cached = nullptr;
+
+    if (cached_serial == serial)
+        return *cached;
+
+    std::lock_guard<std::mutex> guard(workers_lock);
+    workers.push_back(std::make_unique<Worker>(&module));
+    cached = workers.back().get();
+    cached_serial = serial;
+    return *cached;
+}
+
+void ModuleBuilder::freeze(unsigned threads)
+{
+    std::vector<std::pair<std::uint64_t, Module::function_ptr_t>> functions;
+    for (auto &worker : workers)
+        for (auto &func : worker->functions)
+            functions.push_back(std::move(func));
+
+    std::stable_sort(functions.begin(), functions.end(), [](const auto &a, const auto &b)
+                     { return a.first < b.first; });
+
+    /// the functions get consecutive ids from the end of the module
+    auto first = static_cast<std::uint32_t>(module.get_function_id_bound());
+    for (auto &func : functions)
+        module.add_function(std::move(func.second));
+
+    /// the module keeps the memory of the functions from now on
+    for (auto &worker : workers)
+        module.adopt_arena(std::move(worker->arena));
+    workers.clear();
+
+    /// a new serial so the threads do not use the workers just released
+    serial = next_serial++;
+
+    auto finalize = [&](std::size_t i)
+    {
+        module.get_function(first + static_cast<std::uint32_t>(i))->finalize();
+    };
+
+    if (threads == 1 || functions.size() < 2)
+    {
+        for (std::size_t i = 0; i < functions.size(); i++)
+            finalize(i);
+    }
+    else
+    {
+        ThreadPool pool(threads);
+        auto grain = std::max<std::size_t>(1, functions.size() / (pool.size() * 16));
+        pool.parallel_for(functions.size(), finalize, grain);
+    }
+}
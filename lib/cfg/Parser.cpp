@@ -0,0 +1,791 @@
+#include "cfg/Parser.hpp"
+#include "cfg/ModuleBuilder.hpp"
+#include "cfg/ThreadPool.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <deque>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace CFG;
+
+namespace
+{
+    struct ParsedBlock
+    {
+        std::string_view name;
+        std::uint64_t start_addr;
+        std::uint64_t end_addr;
+        bool entry;
+    };
+
+    struct ParsedEdge
+    {
+        block_id_t src;
+        block_id_t dst;
+        std::string_view tag;
+    };
+
+    /// @brief Function parsed from the text, the names point into the
+    /// text or into `unescaped` for the names with escape sequences
+    struct ParsedFunction
+    {
+        std::string_view name;
+        std::vector<ParsedBlock> blocks;
+        std::vector<ParsedEdge> edges;
+        std::deque<std::string> unescaped;
+        /// @brief first error found, with its offset in the text
+        std::string error;
+        std::size_t error_offset{0};
+    };
+
+    /// @brief Error while parsing, turned into a ParseException
+    /// with the line number once the parallel work is done
+    struct ParseError
+    {
+        const char *where;
+        const char *msg;
+    };
+
+    /// @brief Read position over the text, shared by both formats
+    class Cursor
+    {
+    public:
+        const char *p;
+        const char *end;
+        /// @brief storage of the names with escape sequences
+        std::deque<std::string> *unescaped;
+
+        Cursor(const char *begin, const char *end, std::deque<std::string> *unescaped = nullptr)
+            : p(begin), end(end), unescaped(unescaped) {}
+
+        [[noreturn]] void fail(const char *msg) const { throw ParseError{p, msg}; }
+
+        bool at_end() const { return p == end; }
+
+        char peek() const { return p < end ? *p : '\0'; }
+
+        /// @brief Skip spaces and tabs
+        void skip_blanks()
+        {
+            while (p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+                p++;
+        }
+
+        /// @brief Skip every kind of white space, for JSON
+        void skip_space()
+        {
+            while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n'))
+                p++;
+        }
+
+        void expect(char c)
+        {
+            skip_space();
+            if (peek() != c)
+                fail("unexpected character");
+            p++;
+        }
+
+        /// @brief Read a word made of letters
+        std::string_view word()
+        {
+            auto start = p;
+            while (p < end && ((*p >= 'a' && *p <= 'z') || (*p >= 'A' && *p <= 'Z')))
+                p++;
+            return {start, static_cast<std::size_t>(p - start)};
+        }
+
+        /// @brief Read an unsigned number, in hexadecimal with a 0x prefix
+        template <typename T>
+        T number()
+        {
+            int base = 10;
+            if (end - p > 2 && p[0] == '0' && (p[1] == 'x' || p[1] == 'X'))
+            {
+                base = 16;
+                p += 2;
+            }
+
+            T value{};
+            auto result = std::from_chars(p, end, value, base);
+            if (result.ec != std::errc())
+                fail(result.ec == std::errc::result_out_of_range ? "number out of range" : "expected a number");
+            p = result.ptr;
+            return value;
+        }
+
+        /// @brief Read a string between double quotes, the string is
+        /// returned as a view of the text unless it has escape sequences
+        std::string_view string()
+        {
+            if (peek() != '"')
+                fail("expected a string");
+            auto start = ++p;
+
+            while (p < end && *p != '"' && *p != '\\' && *p != '\n')
+                p++;
+
+            if (p < end && *p == '"')
+                return {start, static_cast<std::size_t>(p++ - start)};
+
+            std::string str(start, p);
+            while (p < end && *p != '"')
+            {
+                if (*p == '\n')
+                    fail("unterminated string");
+                if (*p != '\\')
+                {
+                    str += *p++;
+                    continue;
+                }
+                if (++p == end)
+                    break;
+                switch (*p++)
+                {
+                case '"':
+                    str += '"';
+                    break;
+                case '\\':
+                    str += '\\';
+                    break;
+                case '/':
+                    str += '/';
+                    break;
+                case 'b':
+                    str += '\b';
+                    break;
+                case 'f':
+                    str += '\f';
+                    break;
+                case 'n':
+                    str += '\n';
+                    break;
+                case 'r':
+                    str += '\r';
+                    break;
+                case 't':
+                    str += '\t';
+                    break;
+                case 'u':
+                    append_utf8(str, code_point());
+                    break;
+                default:
+                    p--;
+                    fail("invalid escape sequence");
+                }
+            }
+            if (p == end)
+                fail("unterminated string");
+            p++;
+
+            unescaped->push_back(std::move(str));
+            return unescaped->back();
+        }
+
+        /// @brief Skip a JSON value of any type, objects and arrays are
+        /// only matched by their brackets, the values kept are checked
+        /// when they are parsed
+        void skip_value()
+        {
+            skip_space();
+            switch (peek())
+            {
+            case '"':
+                skip_string();
+                break;
+            case '{':
+            case '[':
+            {
+                std::size_t depth = 0;
+                do
+                {
+                    switch (*p)
+                    {
+                    case '"':
+                        skip_string();
+                        continue;
+                    case '{':
+                    case '[':
+                        depth++;
+                        break;
+                    case '}':
+                    case ']':
+                        depth--;
+                        break;
+                    }
+                    p++;
+                } while (p < end && depth > 0);
+                if (depth)
+                    fail("unterminated value");
+                break;
+            }
+            default:
+                /// numbers, true, false and null
+                if (p == end || !(std::isalnum(static_cast<unsigned char>(*p)) || *p == '-'))
+                    fail("expected a value");
+                while (p < end && (std::isalnum(static_cast<unsigned char>(*p)) || *p == '-' || *p == '+' || *p == '.'))
+                    p++;
+            }
+        }
+
+    private:
+        /// @brief Skip a string without decoding its escape sequences
+        void skip_string()
+        {
+            for (p++; p < end && *p != '"'; p++)
+                if (*p == '\\' && p + 1 < end)
+                    p++;
+            if (p == end)
+                fail("unterminated string");
+            p++;
+        }
+
+        std::uint32_t hex4()
+        {
+            std::uint32_t value = 0;
+            auto result = end - p >= 4 ? std::from_chars(p, p + 4, value, 16) : std::from_chars_result{p, std::errc::invalid_argument};
+            if (result.ec != std::errc() || result.ptr != p + 4)
+                fail("invalid \\u escape sequence");
+            p += 4;
+            return value;
+        }
+
+        /// @brief Read the code point of a \u escape, joining surrogate pairs
+        std::uint32_t code_point()
+        {
+            auto cp = hex4();
+            if (cp >= 0xd800 && cp < 0xdc00 && end - p >= 2 && p[0] == '\\' && p[1] == 'u')
+            {
+                p += 2;
+                auto low = hex4();
+                if (low < 0xdc00 || low >= 0xe000)
+                    fail("invalid surrogate pair");
+                cp = 0x10000 + ((cp - 0xd800) << 10) + (low - 0xdc00);
+            }
+            return cp;
+        }
+
+        static void append_utf8(std::string &str, std::uint32_t cp)
+        {
+            if (cp < 0x80)
+                str += static_cast<char>(cp);
+            else if (cp < 0x800)
+            {
+                str += static_cast<char>(0xc0 | (cp >> 6));
+                str += static_cast<char>(0x80 | (cp & 0x3f));
+            }
+            else if (cp < 0x10000)
+            {
+                str += static_cast<char>(0xe0 | (cp >> 12));
+                str += static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+                str += static_cast<char>(0x80 | (cp & 0x3f));
+            }
+            else
+            {
+                str += static_cast<char>(0xf0 | (cp >> 18));
+                str += static_cast<char>(0x80 | ((cp >> 12) & 0x3f));
+                str += static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+                str += static_cast<char>(0x80 | (cp & 0x3f));
+            }
+        }
+    };
+
+    /// @brief Text split in functions, parsed one by one
+    struct Split
+    {
+        std::string_view module_name;
+        std::deque<std::string> unescaped;
+        std::vector<std::pair<const char *, const char *>> functions;
+    };
+
+    /// @brief Skip a line of the edge list that is empty or a comment
+    bool skip_empty_line(Cursor &c)
+    {
+        c.skip_blanks();
+        if (c.at_end() || (*c.p != '\n' && *c.p != '#'))
+            return false;
+        auto eol = static_cast<const char *>(std::memchr(c.p, '\n', c.end - c.p));
+        c.p = eol ? eol + 1 : c.end;
+        return true;
+    }
+
+    void end_of_line(Cursor &c)
+    {
+        c.skip_blanks();
+        if (c.peek() == '#')
+        {
+            auto eol = static_cast<const char *>(std::memchr(c.p, '\n', c.end - c.p));
+            c.p = eol ? eol : c.end;
+        }
+        if (c.at_end())
+            return;
+        if (*c.p != '\n')
+            c.fail("unexpected text at the end of the line");
+        c.p++;
+    }
+
+    /// @brief Find the module line and the lines starting the functions,
+    /// the names cannot have raw new lines so the split is line based
+    void split_edge_list(Cursor &c, Split &split)
+    {
+        while (skip_empty_line(c))
+            ;
+
+        auto line = c.p;
+        if (c.word() == "module")
+        {
+            c.skip_blanks();
+            split.module_name = c.string();
+            end_of_line(c);
+        }
+        else
+            c.p = line;
+
+        while (skip_empty_line(c))
+            ;
+
+        if (c.at_end())
+            return;
+
+        line = c.p;
+        if (c.word() != "function")
+            c.fail("expected a function");
+
+        split.functions.emplace_back(line, c.end);
+
+        /// every line that starts with the keyword begins a new function
+        auto p = c.p;
+        while (auto eol = static_cast<const char *>(std::memchr(p, '\n', c.end - p)))
+        {
+            p = eol + 1;
+            auto q = p;
+            while (q < c.end && (*q == ' ' || *q == '\t'))
+                q++;
+            if (c.end - q > 8 && std::memcmp(q, "function", 8) == 0 && (q[8] == ' ' || q[8] == '\t'))
+            {
+                split.functions.back().second = p;
+                split.functions.emplace_back(p, c.end);
+            }
+        }
+    }
+
+    void parse_edge_list_function(Cursor &c, ParsedFunction &F)
+    {
+        c.skip_blanks();
+        c.word();
+        c.skip_blanks();
+        F.name = c.string();
+        end_of_line(c);
+
+        while (true)
+        {
+            while (skip_empty_line(c))
+                ;
+            if (c.at_end())
+                c.fail("missing end of function");
+
+            auto line = c.p;
+            auto keyword = c.word();
+            c.skip_blanks();
+
+            if (keyword == "block")
+            {
+                auto id = c.number<block_id_t>();
+                if (id != F.blocks.size())
+                {
+                    c.p = line;
+                    c.fail("block ids must start at 0 and be consecutive");
+                }
+
+                ParsedBlock block{};
+                c.skip_blanks();
+                block.name = c.string();
+                c.skip_blanks();
+                block.start_addr = c.number<std::uint64_t>();
+                c.skip_blanks();
+                block.end_addr = c.number<std::uint64_t>();
+                c.skip_blanks();
+                auto flag = c.word();
+                if (flag == "entry")
+                    block.entry = true;
+                else if (!flag.empty())
+                    c.fail("unknown block flag");
+                F.blocks.push_back(block);
+            }
+            else if (keyword == "edge")
+            {
+                ParsedEdge edge{};
+                edge.src = c.number<block_id_t>();
+                c.skip_blanks();
+                edge.dst = c.number<block_id_t>();
+                c.skip_blanks();
+                edge.tag = c.peek() == '"' ? c.string() : std::string_view();
+                F.edges.push_back(edge);
+            }
+            else if (keyword == "end")
+            {
+                end_of_line(c);
+                while (skip_empty_line(c))
+                    ;
+                if (!c.at_end())
+                    c.fail("unexpected text after the end of function");
+                return;
+            }
+            else
+            {
+                c.p = line;
+                c.fail("expected block, edge or end");
+            }
+
+            end_of_line(c);
+        }
+    }
+
+    /// @brief Find the name of the module and the objects of the functions
+    void split_json(Cursor &c, Split &split)
+    {
+        c.expect('{');
+        c.skip_space();
+        if (c.peek() == '}')
+        {
+            c.p++;
+            return;
+        }
+
+        while (true)
+        {
+            c.skip_space();
+            auto key = c.string();
+            c.expect(':');
+            c.skip_space();
+
+            if (key == "module")
+                split.module_name = c.string();
+            else if (key == "functions")
+            {
+                c.expect('[');
+                c.skip_space();
+                if (c.peek() == ']')
+                    c.p++;
+                else
+                    while (true)
+                    {
+                        c.skip_space();
+                        auto begin = c.p;
+                        c.skip_value();
+                        split.functions.emplace_back(begin, c.p);
+                        c.skip_space();
+                        if (c.peek() != ',')
+                        {
+                            c.expect(']');
+                            break;
+                        }
+                        c.p++;
+                    }
+            }
+            else
+                c.skip_value();
+
+            c.skip_space();
+            if (c.peek() != ',')
+                break;
+            c.p++;
+        }
+
+        c.expect('}');
+        c.skip_space();
+        if (!c.at_end())
+            c.fail("unexpected text after the module");
+    }
+
+    /// @brief Call fn for every key of an object, with the cursor on the value
+    template <typename Fn>
+    void json_object(Cursor &c, Fn fn)
+    {
+        c.expect('{');
+        c.skip_space();
+        if (c.peek() == '}')
+        {
+            c.p++;
+            return;
+        }
+        while (true)
+        {
+            c.skip_space();
+            auto key = c.string();
+            c.expect(':');
+            c.skip_space();
+            fn(key);
+            c.skip_space();
+            if (c.peek() != ',')
+                break;
+            c.p++;
+        }
+        c.expect('}');
+    }
+
+    /// @brief Call fn for every element of an array, with the cursor on it
+    template <typename Fn>
+    void json_array(Cursor &c, Fn fn)
+    {
+        c.expect('[');
+        c.skip_space();
+        if (c.peek() == ']')
+        {
+            c.p++;
+            return;
+        }
+        while (true)
+        {
+            c.skip_space();
+            fn();
+            c.skip_space();
+            if (c.peek() != ',')
+                break;
+            c.p++;
+        }
+        c.expect(']');
+    }
+
+    bool json_bool(Cursor &c)
+    {
+        auto value = c.word();
+        if (value == "true")
+            return true;
+        if (value != "false")
+            c.fail("expected true or false");
+        return false;
+    }
+
+    void parse_json_function(Cursor &c, ParsedFunction &F)
+    {
+        json_object(c, [&](std::string_view key)
+                    {
+                        if (key == "name")
+                            F.name = c.string();
+                        else if (key == "blocks")
+                            json_array(c, [&]()
+                                       {
+                                           auto start = c.p;
+                                           ParsedBlock block{};
+                                           block_id_t id = F.blocks.size();
+                                           json_object(c, [&](std::string_view field)
+                                                       {
+                                                           if (field == "id")
+                                                               id = c.number<block_id_t>();
+                                                           else if (field == "name")
+                                                               block.name = c.string();
+                                                           else if (field == "start")
+                                                               block.start_addr = c.number<std::uint64_t>();
+                                                           else if (field == "end")
+                                                               block.end_addr = c.number<std::uint64_t>();
+                                                           else if (field == "entry")
+                                                               block.entry = json_bool(c);
+                                                           else
+                                                               c.skip_value(); });
+                                           if (id != F.blocks.size())
+                                           {
+                                               c.p = start;
+                                               c.fail("block ids must start at 0 and be consecutive");
+                                           }
+                                           F.blocks.push_back(block); });
+                        else if (key == "edges")
+                            json_array(c, [&]()
+                                       {
+                                           ParsedEdge edge{};
+                                           c.expect('[');
+                                           c.skip_space();
+                                           edge.src = c.number<block_id_t>();
+                                           c.expect(',');
+                                           c.skip_space();
+                                           edge.dst = c.number<block_id_t>();
+                                           c.skip_space();
+                                           if (c.peek() == ',')
+                                           {
+                                               c.p++;
+                                               c.skip_space();
+                                               edge.tag = c.string();
+                                           }
+                                           c.expect(']');
+                                           F.edges.push_back(edge); });
+                        else
+                            c.skip_value(); });
+    }
+
+    /// @brief Number of the line of a position, only used for errors
+    std::size_t line_of(std::string_view text, const char *where)
+    {
+        return 1 + std::count(text.data(), where, '\n');
+    }
+
+    [[noreturn]] void report(std::string_view text, const std::string &source, const char *where, const std::string &msg)
+    {
+        throw exceptions::ParseException(source + ":" + std::to_string(line_of(text, where)) + ": " + msg);
+    }
+
+    /// @brief File mapped in memory for reading
+    class MappedFile
+    {
+        const char *data{nullptr};
+        std::size_t size{0};
+
+    public:
+        explicit MappedFile(const std::string &path)
+        {
+            int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0)
+                throw exceptions::ParseException("Cannot open " + path);
+
+            struct stat st;
+            if (::fstat(fd, &st) < 0)
+            {
+                ::close(fd);
+                throw exceptions::ParseException("Cannot read " + path);
+            }
+
+            size = static_cast<std::size_t>(st.st_size);
+            if (size)
+            {
+                void *mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (mapping == MAP_FAILED)
+                {
+                    ::close(fd);
+                    throw exceptions::ParseException("Cannot map " + path);
+                }
+                /// the file is read once from the start to the end
+                ::madvise(mapping, size, MADV_SEQUENTIAL);
+                data = static_cast<const char *>(mapping);
+            }
+            ::close(fd);
+        }
+
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+
+        ~MappedFile()
+        {
+            if (data)
+                ::munmap(const_cast<char *>(data), size);
+        }
+
+        std::string_view get_text() const { return {data, size}; }
+    };
+} // namespace
+
+std::unique_ptr<Module> CFG::parse_module(std::string_view text, InputFormat format, unsigned threads, const std::string &source)
+{
+    auto begin = text.data();
+    auto end = begin + text.size();
+
+    if (format == InputFormat::Auto)
+    {
+        Cursor c(begin, end);
+        c.skip_space();
+        format = c.peek() == '{' ? InputFormat::Json : InputFormat::EdgeList;
+    }
+
+    Split split;
+    try
+    {
+        Cursor c(begin, end, &split.unescaped);
+        if (format == InputFormat::Json)
+            split_json(c, split);
+        else
+            split_edge_list(c, split);
+    }
+    catch (ParseError &e)
+    {
+        report(text, source, e.where, e.msg);
+    }
+
+    std::vector<ParsedFunction> parsed(split.functions.size());
+
+    auto M = std::make_unique<Module>(std::string(split.module_name));
+    ModuleBuilder builder(*M);
+
+    /// each function is built by the thread that parsed it, the
+    /// index in the file keeps the functions in file order
+    auto parse_one = [&](std::size_t i)
+    {
+        auto &F = parsed[i];
+        Cursor c(split.functions[i].first, split.functions[i].second, &F.unescaped);
+        try
+        {
+            if (format == InputFormat::Json)
+                parse_json_function(c, F);
+            else
+                parse_edge_list_function(c, F);
+
+            for (const auto &edge : F.edges)
+                if (edge.src >= F.blocks.size() || edge.dst >= F.blocks.size())
+                    throw ParseError{split.functions[i].first, "edge with a block that does not exist"};
+        }
+        catch (ParseError &e)
+        {
+            F.error = e.msg;
+            F.error_offset = e.where - begin;
+            return;
+        }
+
+        auto Fn = builder.get_worker().create_function(F.name, i);
+
+        std::vector<BasicBlock *> bbs;
+        bbs.reserve(F.blocks.size());
+        for (const auto &block : F.blocks)
+        {
+            auto bb = BasicBlock::Create(block.name, Fn);
+            bb->set_start_addr(block.start_addr);
+            bb->set_end_addr(block.end_addr);
+            bb->set_entry_block(block.entry);
+            bbs.push_back(bb);
+        }
+
+        std::vector<Function::Edge> batch;
+        batch.reserve(F.edges.size());
+        for (const auto &edge : F.edges)
+            batch.push_back({bbs[edge.src], bbs[edge.dst], edge.tag});
+        if (Fn->add_successors(batch))
+        {
+            F.error = "duplicated edge in function " + std::string(F.name);
+            F.error_offset = split.functions[i].first - begin;
+        }
+
+        /// the records are not needed once the function is built
+        std::vector<ParsedBlock>().swap(F.blocks);
+        std::vector<ParsedEdge>().swap(F.edges);
+    };
+
+    if (threads == 1 || parsed.size() < 2)
+    {
+        for (std::size_t i = 0; i < parsed.size(); i++)
+            parse_one(i);
+    }
+    else
+    {
+        ThreadPool pool(threads);
+        pool.parallel_for(parsed.size(), parse_one, parsed.size() / (pool.size() * 16));
+    }
+
+    /// the first error in file order wins
+    for (const auto &F : parsed)
+        if (!F.error.empty())
+            report(text, source, begin + F.error_offset, F.error);
+
+    builder.freeze(threads);
+
+    return M;
+}
+
+std::unique_ptr<Module> CFG::load_module(const std::string &path, InputFormat format, unsigned threads)
+{
+    MappedFile file(path);
+    return parse_module(file.get_text(), format, threads, path);
+}
@@ -0,0 +1,162 @@
+#include "cfg/SCC.hpp"
+#include "cfg/Function.hpp"
+
+using namespace CFG;
+
+void StronglyConnectedComponents::compute(const std::vector<std::uint32_t> &offsets, const std::vector<node_t> &targets)
+{
+    const std::size_t n = offsets.empty() ? 0 : offsets.size() - 1;
+
+    /// rindex is 0 for nodes not visited yet, the visit number for the
+    /// nodes being visited, and a number counting down from n - 1 for the
+    /// nodes already assigned to a component, so a single array is enough
+    std::vector<node_t> rindex(n, 0);
+    node_t index = 1;
+    node_t c = static_cast<node_t>(n) - 1;
+
+    struct Frame
+    {
+        node_t node;
+        std::uint32_t edge;
+        bool root;
+    };
+    std::vector<Frame> calls;
+    std::vector<node_t> stack;
+
+    auto begin_visit = [&](node_t v)
+    {
+        rindex[v] = index++;
+        calls.push_back({v, offsets[v], true});
+    };
+
+    for (node_t start = 0; start < n; start++)
+    {
+        if (rindex[start])
+            continue;
+
+        begin_visit(start);
+
+        while (!calls.empty())
+        {
+            auto &frame = calls.back();
+            auto v = frame.node;
+
+            bool descended = false;
+            for (; frame.edge < offsets[v + 1]; frame.edge++)
+            {
+                auto w = targets[frame.edge];
+                if (!rindex[w])
+                {
+                    /// the edge is finished when the visit of w returns
+                    begin_visit(w);
+                    descended = true;
+                    break;
+                }
+                if (rindex[w] < rindex[v])
+                {
+                    rindex[v] = rindex[w];
+                    frame.root = false;
+                }
+            }
+
+            if (descended)
+                continue;
+
+            bool root = frame.root;
+            calls.pop_back();
+
+            if (root)
+            {
+                index--;
+                while (!stack.empty() && rindex[v] <= rindex[stack.back()])
+                {
+                    rindex[stack.back()] = c;
+                    stack.pop_back();
+                    index--;
+                }
+                rindex[v] = c--;
+            }
+            else
+                stack.push_back(v);
+
+            /// finish the edge from the parent
+            if (!calls.empty())
+            {
+                auto &parent = calls.back();
+                if (rindex[v] < rindex[parent.node])
+                {
+                    rindex[parent.node] = rindex[v];
+                    parent.root = false;
+                }
+                parent.edge++;
+            }
+        }
+    }
+
+    /// the first component found is a sink and got n - 1, renumber
+    /// from 0 so the components are in topological order
+    const node_t first = c + 1;
+    const std::size_t num = n - first;
+
+    component.resize(n);
+    member_offsets.assign(num + 1, 0);
+    for (node_t v = 0; v < n; v++)
+    {
+        component[v] = rindex[v] - first;
+        member_offsets[component[v] + 1]++;
+    }
+    for (std::size_t i = 0; i < num; i++)
+        member_offsets[i + 1] += member_offsets[i];
+
+    members.resize(n);
+    {
+        std::vector<std::uint32_t> cursor(member_offsets.begin(), member_offsets.end() - 1);
+        for (node_t v = 0; v < n; v++)
+            members[cursor[component[v]]++] = v;
+    }
+
+    /// edges of the condensation, `seen` remembers the last
+    /// component that added each target to skip repeated edges
+    cyclic.assign(num, false);
+    dag_offsets.assign(num + 1, 0);
+    dag_targets.clear();
+    std::vector<node_t> seen(num, static_cast<node_t>(num));
+
+    for (node_t comp = 0; comp < num; comp++)
+    {
+        cyclic[comp] = member_offsets[comp + 1] - member_offsets[comp] > 1;
+
+        for (auto m = member_offsets[comp]; m < member_offsets[comp + 1]; m++)
+        {
+            auto v = members[m];
+            for (auto e = offsets[v]; e < offsets[v + 1]; e++)
+            {
+                auto target = component[targets[e]];
+                if (target == comp)
+                {
+                    cyclic[comp] = true;
+                    continue;
+                }
+                if (seen[target] == comp)
+                    continue;
+                seen[target] = comp;
+                dag_targets.push_back(target);
+            }
+        }
+
+        dag_offsets[comp + 1] = static_cast<std::uint32_t>(dag_targets.size());
+    }
+}
+
+BlockSCCs::BlockSCCs(const Function &F)
+{
+    if (F.is_finalized())
+    {
+        compute(F.get_csr().succ_offsets, F.get_csr().succ_targets);
+        return;
+    }
+
+    CSREdges local;
+    F.pack_edges(local);
+    compute(local.succ_offsets, local.succ_targets);
+}
@@ -0,0 +1,379 @@
+#include "cfg/Serialization.hpp"
+
+#include <atomic>
+#include <cstring>
+#include <limits>
+#include <fstream>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace CFG;
+
+namespace
+{
+    /// @brief Check that a count or offset fits in the 32 bit fields of
+    /// the format, a truncated value would give a corrupt file
+    std::uint32_t narrow(std::uint64_t value, const std::string &what)
+    {
+        if (value > std::numeric_limits<std::uint32_t>::max())
+            throw exceptions::SerializationException(what + " does not fit in the format (" + std::to_string(value) + ")");
+        return static_cast<std::uint32_t>(value);
+    }
+
+    /// @brief Strings of the file, each different string is stored once
+    class StringTable
+    {
+        std::string data;
+        std::unordered_map<std::string, format::StringRef> refs;
+
+    public:
+        format::StringRef add(std::string_view str)
+        {
+            auto it = refs.find(std::string(str));
+            if (it != refs.end())
+                return it->second;
+
+            /// the end of every string must be addressable with 32 bits
+            narrow(data.size() + str.size(), "size of the string table");
+            format::StringRef ref{static_cast<std::uint32_t>(data.size()), static_cast<std::uint32_t>(str.size())};
+            data.append(str);
+            refs.emplace(std::string(str), ref);
+            return ref;
+        }
+
+        const std::string &get_data() const { return data; }
+    };
+
+    /// @brief Sections are aligned to 8 bytes
+    std::uint64_t align(std::uint64_t offset)
+    {
+        return (offset + 7) & ~std::uint64_t(7);
+    }
+} // namespace
+
+void CFG::write_module(const Module &M, const std::string &path)
+{
+    StringTable strings;
+    std::unordered_map<std::string, tag_id_t> tag_ids;
+    std::vector<format::StringRef> tags;
+    std::vector<format::FunctionRecord> functions;
+    std::vector<format::BlockRecord> blocks;
+    std::vector<std::uint32_t> succ_offsets, pred_offsets;
+    std::vector<block_id_t> succ_targets, pred_sources;
+    std::vector<tag_id_t> succ_tags;
+
+    format::Header header{};
+    std::memcpy(header.magic, format::magic, sizeof(header.magic));
+    header.version = format::version;
+    header.byte_order = format::byte_order_mark;
+    header.module_name = strings.add(M.get_name());
+
+    CSREdges edges;
+
+    for (const auto &func : M.get_functions())
+    {
+        auto bbs = func->get_basic_blocks();
+
+        /// the CSR offsets of a function are 32 bits, the edges are
+        /// counted before packing them
+        std::uint64_t num_edges = 0;
+        for (const auto &bb : bbs)
+            num_edges += func->successors(bb.get()).size();
+        narrow(num_edges, "number of edges of function " + std::string(func->get_name()));
+
+        /// the blocks are written in order and numbered by their position,
+        /// the slots of deleted blocks are not stored
+        func->pack_edges(edges, true);
+
+        format::FunctionRecord record{};
+        record.name = strings.add(func->get_name());
+        record.num_blocks = narrow(bbs.size(), "number of blocks of function " + std::string(func->get_name()));
+        record.first_block = blocks.size();
+        record.first_offset = succ_offsets.size();
+        record.first_edge = succ_targets.size();
+        record.first_pred_edge = pred_sources.size();
+        functions.push_back(record);
+
+        for (const auto &bb : bbs)
+        {
+            format::BlockRecord block{};
+            block.start_addr = bb->get_start_addr();
+            block.end_addr = bb->get_end_addr();
+            block.name = strings.add(bb->get_name());
+            block.flags = bb->get_entry_block() ? format::block_entry : 0;
+            blocks.push_back(block);
+        }
+
+        if (edges.succ_offsets.empty())
+        {
+            succ_offsets.push_back(0);
+            pred_offsets.push_back(0);
+        }
+        else
+        {
+            succ_offsets.insert(succ_offsets.end(), edges.succ_offsets.begin(), edges.succ_offsets.end());
+            pred_offsets.insert(pred_offsets.end(), edges.pred_offsets.begin(), edges.pred_offsets.end());
+        }
+
+        succ_targets.insert(succ_targets.end(), edges.succ_targets.begin(), edges.succ_targets.end());
+        pred_sources.insert(pred_sources.end(), edges.pred_sources.begin(), edges.pred_sources.end());
+
+        /// the tags of the function are renumbered with the ids of the file
+        for (auto tag : edges.succ_tags)
+        {
+            auto str = edges.tags.get(tag);
+            auto it = tag_ids.find(std::string(str));
+            if (it == tag_ids.end())
+            {
+                it = tag_ids.emplace(std::string(str), narrow(tags.size(), "number of tags")).first;
+                tags.push_back(strings.add(str));
+            }
+            succ_tags.push_back(it->second);
+        }
+    }
+
+    header.num_functions = narrow(functions.size(), "number of functions");
+    header.num_blocks = blocks.size();
+    header.num_edges = succ_targets.size();
+    header.num_pred_edges = pred_sources.size();
+    header.num_tags = narrow(tags.size(), "number of tags");
+
+    /// place the sections one after the other
+    std::uint64_t offset = align(sizeof(format::Header));
+    auto place = [&](std::uint64_t &section, std::uint64_t bytes)
+    {
+        section = offset;
+        offset = align(offset + bytes);
+    };
+
+    place(header.strings, strings.get_data().size());
+    header.strings_size = strings.get_data().size();
+    place(header.tags, tags.size() * sizeof(format::StringRef));
+    place(header.functions, functions.size() * sizeof(format::FunctionRecord));
+    place(header.blocks, blocks.size() * sizeof(format::BlockRecord));
+    place(header.succ_offsets, succ_offsets.size() * sizeof(std::uint32_t));
+    place(header.succ_targets, succ_targets.size() * sizeof(block_id_t));
+    place(header.succ_tags, succ_tags.size() * sizeof(tag_id_t));
+    place(header.pred_offsets, pred_offsets.size() * sizeof(std::uint32_t));
+    place(header.pred_sources, pred_sources.size() * sizeof(block_id_t));
+
+    std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+    if (!stream)
+        throw exceptions::SerializationException("Cannot open " + path + " for writing");
+
+    std::uint64_t written = 0;
+    auto write = [&](std::uint64_t section, const void *bytes, std::size_t size)
+    {
+        static const char padding[8] = {};
+        stream.write(padding, section - written);
+        stream.write(static_cast<const char *>(bytes), size);
+        written = section + size;
+    };
+
+    write(0, &header, sizeof(header));
+    write(header.strings, strings.get_data().data(), strings.get_data().size());
+    write(header.tags, tags.data(), tags.size() * sizeof(format::StringRef));
+    write(header.functions, functions.data(), functions.size() * sizeof(format::FunctionRecord));
+    write(header.blocks, blocks.data(), blocks.size() * sizeof(format::BlockRecord));
+    write(header.succ_offsets, succ_offsets.data(), succ_offsets.size() * sizeof(std::uint32_t));
+    write(header.succ_targets, succ_targets.data(), succ_targets.size() * sizeof(block_id_t));
+    write(header.succ_tags, succ_tags.data(), succ_tags.size() * sizeof(tag_id_t));
+    write(header.pred_offsets, pred_offsets.data(), pred_offsets.size() * sizeof(std::uint32_t));
+    write(header.pred_sources, pred_sources.data(), pred_sources.size() * sizeof(block_id_t));
+
+    if (!stream)
+        throw exceptions::SerializationException("Error writing " + path);
+}
+
+MappedModule::MappedModule(const std::string &path)
+{
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw exceptions::SerializationException("Cannot open " + path);
+
+    struct stat st;
+    if (::fstat(fd, &st) < 0 || static_cast<std::size_t>(st.st_size) < sizeof(format::Header))
+    {
+        ::close(fd);
+        throw exceptions::SerializationException(path + " is not a serialized module");
+    }
+
+    size = static_cast<std::size_t>(st.st_size);
+    void *mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+
+    if (mapping == MAP_FAILED)
+        throw exceptions::SerializationException("Cannot map " + path);
+
+    data = static_cast<const std::byte *>(mapping);
+    header = reinterpret_cast<const format::Header *>(data);
+
+    auto fail = [&](const std::string &msg)
+    {
+        ::munmap(const_cast<std::byte *>(data), size);
+        throw exceptions::SerializationException(path + ": " + msg);
+    };
+
+    if (std::memcmp(header->magic, format::magic, sizeof(format::magic)) != 0)
+        fail("not a serialized module");
+    if (header->byte_order != format::byte_order_mark)
+        fail("written with a different byte order");
+    if (header->version != format::version)
+        fail("unsupported version " + std::to_string(header->version));
+
+    /// every section must be inside the file and aligned
+    auto check = [&](std::uint64_t section, std::uint64_t count, std::uint64_t elem)
+    {
+        if (section > size || count > (size - section) / elem)
+            fail("truncated file");
+        if (section % 8 != 0)
+            fail("misaligned section");
+    };
+
+    check(header->strings, header->strings_size, 1);
+    check(header->tags, header->num_tags, sizeof(format::StringRef));
+    check(header->functions, header->num_functions, sizeof(format::FunctionRecord));
+    check(header->blocks, header->num_blocks, sizeof(format::BlockRecord));
+    check(header->succ_offsets, header->num_blocks + header->num_functions, sizeof(std::uint32_t));
+    check(header->succ_targets, header->num_edges, sizeof(block_id_t));
+    check(header->succ_tags, header->num_edges, sizeof(tag_id_t));
+    check(header->pred_offsets, header->num_blocks + header->num_functions, sizeof(std::uint32_t));
+    check(header->pred_sources, header->num_pred_edges, sizeof(block_id_t));
+
+    if (header->module_name.offset > header->strings_size ||
+        header->module_name.length > header->strings_size - header->module_name.offset)
+        fail("string out of bounds");
+
+    /// the records of each function are checked by get_function the
+    /// first time the function is requested
+    checked = std::make_unique<std::atomic<bool>[]>(header->num_functions);
+}
+
+void MappedModule::check_function(std::size_t f) const
+{
+    auto fail = [&](const std::string &msg)
+    {
+        throw exceptions::SerializationException("function " + std::to_string(f) + " " + msg);
+    };
+
+    auto check_string = [&](format::StringRef ref)
+    {
+        if (ref.offset > header->strings_size || ref.length > header->strings_size - ref.offset)
+            fail("has a string out of bounds");
+    };
+
+    const auto &function = section<format::FunctionRecord>(header->functions)[f];
+    const std::uint64_t num_offsets = header->num_blocks + header->num_functions;
+    const std::uint64_t n = function.num_blocks;
+
+    check_string(function.name);
+
+    if (function.first_block > header->num_blocks || n > header->num_blocks - function.first_block ||
+        function.first_offset > num_offsets || n + 1 > num_offsets - function.first_offset)
+        fail("out of bounds");
+
+    auto blocks = section<format::BlockRecord>(header->blocks) + function.first_block;
+    for (std::uint64_t b = 0; b < n; b++)
+        check_string(blocks[b].name);
+
+    /// offsets must grow and stay inside the edges of the file
+    auto check_edges = [&](const std::uint32_t *offsets, std::uint64_t first_edge, std::uint64_t total,
+                           const block_id_t *ids)
+    {
+        if (offsets[0] != 0)
+            fail("has invalid edge offsets");
+        for (std::uint64_t b = 0; b < n; b++)
+            if (offsets[b + 1] < offsets[b])
+                fail("has invalid edge offsets");
+        if (first_edge > total || offsets[n] > total - first_edge)
+            fail("has edges out of bounds");
+
+        for (std::uint64_t e = 0; e < offsets[n]; e++)
+            if (ids[first_edge + e] >= n)
+                fail("has an edge to an invalid block");
+    };
+
+    auto succ_offsets = section<std::uint32_t>(header->succ_offsets) + function.first_offset;
+    auto pred_offsets = section<std::uint32_t>(header->pred_offsets) + function.first_offset;
+    auto succ_targets = section<block_id_t>(header->succ_targets) + function.first_edge;
+    auto pred_sources = section<block_id_t>(header->pred_sources) + function.first_pred_edge;
+
+    check_edges(succ_offsets, function.first_edge, header->num_edges, section<block_id_t>(header->succ_targets));
+    check_edges(pred_offsets, function.first_pred_edge, header->num_pred_edges, section<block_id_t>(header->pred_sources));
+
+    auto tags = section<format::StringRef>(header->tags);
+    auto succ_tags = section<tag_id_t>(header->succ_tags) + function.first_edge;
+    for (std::uint64_t e = 0; e < succ_offsets[n]; e++)
+    {
+        if (succ_tags[e] >= header->num_tags)
+            fail("has an invalid edge tag");
+        check_string(tags[succ_tags[e]]);
+    }
+
+    /// the predecessors must be the sucessors reversed, the writer
+    /// stores them in order of source block, so walking the sucessors
+    /// in that order must find each edge at the next predecessor slot
+    if (succ_offsets[n] != pred_offsets[n])
+        fail("has predecessors that do not match its sucessors");
+
+    std::vector<std::uint32_t> cursor(pred_offsets, pred_offsets + n);
+    for (std::uint64_t src = 0; src < n; src++)
+        for (auto e = succ_offsets[src]; e < succ_offsets[src + 1]; e++)
+        {
+            auto dst = succ_targets[e];
+            if (cursor[dst] == pred_offsets[dst + 1] || pred_sources[cursor[dst]++] != src)
+                fail("has predecessors that do not match its sucessors");
+        }
+
+    checked[f].store(true, std::memory_order_release);
+}
+
+MappedModule::~MappedModule()
+{
+    if (data)
+        ::munmap(const_cast<std::byte *>(data), size);
+}
+
+std::unique_ptr<Module> MappedModule::to_module() const
+{
+    auto M = std::make_unique<Module>(get_name());
+
+    std::vector<BasicBlock *> bbs;
+    std::vector<Function::Edge> edges;
+
+    for (std::size_t f = 0; f < num_functions(); f++)
+    {
+        auto view = get_function(f);
+        auto Fn = Function::Create(view.get_name(), M.get());
+
+        bbs.clear();
+        for (block_id_t b = 0; b < view.num_blocks(); b++)
+        {
+            auto block = view.get_basic_block(b);
+            auto bb = BasicBlock::Create(block.get_name(), Fn);
+            bb->set_start_addr(block.get_start_addr());
+            bb->set_end_addr(block.get_end_addr());
+            bb->set_entry_block(block.get_entry_block());
+            bbs.push_back(bb);
+        }
+
+        edges.clear();
+        for (block_id_t b = 0; b < view.num_blocks(); b++)
+        {
+            auto block = view.get_basic_block(b);
+            for (std::size_t i = 0; i < block.num_sucessors(); i++)
+            {
+                auto edge = block.get_sucessor(i);
+                edges.push_back({bbs[b], bbs[edge.target], edge.tag});
+            }
+        }
+        Fn->add_successors(edges);
+    }
+
+    return M;
+}
@@ -0,0 +1,305 @@
+#include "cfg/Stats.hpp"
+#include "cfg/Exporter.hpp"
+#include "cfg/Module.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <mutex>
+
+using namespace CFG;
+
+namespace
+{
+    constexpr std::size_t num_ops = static_cast<std::size_t>(StatOp::Count);
+
+    /// @brief counters of one operation in one thread, only written by
+    /// their thread, so a load and a store replace the atomic increment
+    struct Counters
+    {
+        std::atomic<std::uint64_t> count{0};
+        std::atomic<std::uint64_t> timed{0};
+        std::atomic<std::uint64_t> cycles{0};
+        std::array<std::atomic<std::uint64_t>, Stats::buckets> histogram{};
+    };
+
+    void bump(std::atomic<std::uint64_t> &counter, std::uint64_t value)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    void add_into(Stats::Snapshot &snapshot, const Counters &c)
+    {
+        snapshot.count += c.count.load(std::memory_order_relaxed);
+        snapshot.timed += c.timed.load(std::memory_order_relaxed);
+        snapshot.cycles += c.cycles.load(std::memory_order_relaxed);
+        for (std::size_t b = 0; b < Stats::buckets; b++)
+            snapshot.histogram[b] += c.histogram[b].load(std::memory_order_relaxed);
+    }
+
+    void clear(Counters &c)
+    {
+        c.count.store(0, std::memory_order_relaxed);
+        c.timed.store(0, std::memory_order_relaxed);
+        c.cycles.store(0, std::memory_order_relaxed);
+        for (auto &bucket : c.histogram)
+            bucket.store(0, std::memory_order_relaxed);
+    }
+
+    struct ThreadCounters;
+
+    /// @brief counters of the running threads, and the sum of the
+    /// counters of the threads that finished
+    struct Registry
+    {
+        std::mutex lock;
+        std::vector<ThreadCounters *> threads;
+        std::array<Stats::Snapshot, num_ops> finished{};
+
+        static Registry &get()
+        {
+            /// never destroyed, threads may finish after the static
+            /// objects are destroyed
+            static auto registry = new Registry;
+            return *registry;
+        }
+    };
+
+    struct ThreadCounters
+    {
+        std::array<Counters, num_ops> ops;
+        /// @brief calls left until the next timed one
+        std::uint32_t countdown{1};
+
+        ThreadCounters()
+        {
+            auto &registry = Registry::get();
+            std::lock_guard<std::mutex> guard(registry.lock);
+            registry.threads.push_back(this);
+        }
+
+        ~ThreadCounters()
+        {
+            auto &registry = Registry::get();
+            std::lock_guard<std::mutex> guard(registry.lock);
+            for (std::size_t i = 0; i < num_ops; i++)
+                add_into(registry.finished[i], ops[i]);
+            std::erase(registry.threads, this);
+        }
+
+        static ThreadCounters &get()
+        {
+            thread_local ThreadCounters counters;
+            return counters;
+        }
+    };
+
+    void write_field(OutputBuffer &out, std::string_view name, std::uint64_t value)
+    {
+        out.write('"').write(name).write("\":").write_uint(value);
+    }
+} // namespace
+
+std::string_view CFG::stat_op_name(StatOp op)
+{
+    switch (op)
+    {
+    case StatOp::AddSucessor:
+        return "add_sucessor";
+    case StatOp::AddSuccessors:
+        return "add_successors";
+    case StatOp::DeleteBasicBlock:
+        return "delete_basic_block";
+    case StatOp::ValidateFunction:
+        return "validate_function";
+    case StatOp::DumpFunctionDot:
+        return "dump_function_dot";
+    default:
+        return "unknown";
+    }
+}
+
+bool Stats::begin(StatOp op)
+{
+    auto &counters = ThreadCounters::get();
+    bump(counters.ops[static_cast<std::size_t>(op)].count, 1);
+
+    if (--counters.countdown)
+        return false;
+    counters.countdown = get_sample_period();
+    return true;
+}
+
+void Stats::record(StatOp op, std::uint64_t cycles)
+{
+    auto &c = ThreadCounters::get().ops[static_cast<std::size_t>(op)];
+    auto bucket = std::min<std::size_t>(std::bit_width(cycles), buckets - 1);
+
+    bump(c.timed, 1);
+    bump(c.cycles, cycles);
+    bump(c.histogram[bucket], 1);
+}
+
+Stats::Snapshot Stats::get(StatOp op)
+{
+    auto i = static_cast<std::size_t>(op);
+    auto &registry = Registry::get();
+    std::lock_guard<std::mutex> guard(registry.lock);
+
+    auto snapshot = registry.finished[i];
+    for (auto thread : registry.threads)
+        add_into(snapshot, thread->ops[i]);
+    return snapshot;
+}
+
+void Stats::reset()
+{
+    auto &registry = Registry::get();
+    std::lock_guard<std::mutex> guard(registry.lock);
+
+    registry.finished = {};
+    for (auto thread : registry.threads)
+        for (auto &c : thread->ops)
+            clear(c);
+}
+
+void Stats::export_json(OutputBuffer &out)
+{
+    out.write("{\"compiled_in\":").write(compiled_in() ? "true" : "false");
+    out.write(",\"enabled\":").write(is_enabled() ? "true" : "false").write(',');
+    write_field(out, "sample_period", get_sample_period());
+    out.write(",\"operations\":{");
+
+    for (std::size_t i = 0; i < num_ops; i++)
+    {
+        auto op = static_cast<StatOp>(i);
+        auto snapshot = get(op);
+
+        if (i)
+            out.write(',');
+        out.write('"').write(stat_op_name(op)).write("\":{");
+        write_field(out, "count", snapshot.count);
+        out.write(',');
+        write_field(out, "timed", snapshot.timed);
+        out.write(',');
+        write_field(out, "cycles", snapshot.cycles);
+        out.write(',');
+        write_field(out, "mean_cycles", snapshot.timed ? snapshot.cycles / snapshot.timed : 0);
+
+        /// only the buckets used, each one with its upper bound
+        out.write(",\"histogram\":[");
+        bool first = true;
+        for (std::size_t b = 0; b < buckets; b++)
+        {
+            if (!snapshot.histogram[b])
+                continue;
+            if (!first)
+                out.write(',');
+            first = false;
+            out.write('{');
+            write_field(out, "below_cycles", std::uint64_t(1) << b);
+            out.write(',');
+            write_field(out, "count", snapshot.histogram[b]);
+            out.write('}');
+        }
+        out.write("]}");
+    }
+
+    out.write("}}");
+}
+
+FunctionStats CFG::collect_stats(const Function &F)
+{
+    FunctionStats stats;
+    auto blocks = F.get_basic_blocks();
+
+    stats.blocks = blocks.size();
+    stats.block_bytes = blocks.size() * sizeof(BasicBlock);
+    stats.edge_bytes = F.get_edge_bytes();
+    stats.instruction_bytes = F.get_instruction_buffer().get_bytes();
+
+    for (const auto &bb : blocks)
+    {
+        auto degree = F.successors(bb.get()).size();
+        if (degree >= stats.out_degree.size())
+            stats.out_degree.resize(degree + 1);
+        stats.out_degree[degree]++;
+        stats.edges += degree;
+    }
+
+    /// breadth first search from the entry, the depth of the last
+    /// level reached is the longest shortest path
+    auto entry = std::find_if(blocks.begin(), blocks.end(), [](const Function::block_ptr_t &bb)
+                              { return bb->get_entry_block(); });
+    if (entry == blocks.end())
+        return stats;
+
+    std::vector<bool> seen(F.get_block_id_bound());
+    std::vector<const BasicBlock *> level{entry->get()}, next;
+    seen[(*entry)->get_id()] = true;
+
+    while (true)
+    {
+        next.clear();
+        for (auto bb : level)
+            for (auto succ : F.successors(bb))
+                if (!seen[succ->get_id()])
+                {
+                    seen[succ->get_id()] = true;
+                    next.push_back(succ);
+                }
+
+        if (next.empty())
+            break;
+        stats.max_depth++;
+        level.swap(next);
+    }
+
+    return stats;
+}
+
+void CFG::export_module_stats(const Module &M, OutputBuffer &out)
+{
+    out.write("{\"module\":").write_quoted(M.get_name()).write(',');
+    write_field(out, "arena_bytes", M.get_arena_bytes());
+    out.write(",\"stats\":");
+    Stats::export_json(out);
+    out.write(",\"functions\":[");
+
+    bool first = true;
+    for (const auto &func : M.get_functions())
+    {
+        auto stats = collect_stats(*func);
+
+        if (!first)
+            out.write(',');
+        first = false;
+        out.write("{\"name\":").write_quoted(func->get_name()).write(',');
+        write_field(out, "blocks", stats.blocks);
+        out.write(',');
+        write_field(out, "edges", stats.edges);
+        out.write(',');
+        write_field(out, "max_depth", stats.max_depth);
+
+        out.write(",\"out_degree\":[");
+        for (std::size_t d = 0; d < stats.out_degree.size(); d++)
+        {
+            if (d)
+                out.write(',');
+            out.write_uint(stats.out_degree[d]);
+        }
+
+        out.write("],\"bytes\":{");
+        write_field(out, "blocks", stats.block_bytes);
+        out.write(',');
+        write_field(out, "edges", stats.edge_bytes);
+        out.write(',');
+        write_field(out, "instructions", stats.instruction_bytes);
+        out.write(',');
+        write_field(out, "total", stats.total_bytes());
+        out.write(',');
+        write_field(out, "per_block", stats.blocks ? stats.total_bytes() / stats.blocks : 0);
+        out.write("}}");
+    }
+
+    out.write("]}");
+}
@@ -0,0 +1,308 @@
+#include "cfg/StructuralHash.hpp"
+#include "cfg/Module.hpp"
+#include "cfg/ThreadPool.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <string_view>
+#include <unordered_map>
+
+using namespace CFG;
+
+namespace
+{
+    /// @brief finalizer of splitmix64, every bit of the input
+    /// changes about half of the bits of the output
+    std::uint64_t mix(std::uint64_t x)
+    {
+        x += 0x9e3779b97f4a7c15;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111eb;
+        return x ^ (x >> 31);
+    }
+
+    /// @brief hash of an ordered pair
+    std::uint64_t combine(std::uint64_t a, std::uint64_t b)
+    {
+        return mix(a ^ mix(b));
+    }
+
+    /// @brief packed edges of a function, the own ones
+    /// when it is finalized, otherwise written in `local`
+    const CSREdges &get_edges(const Function &F, CSREdges &local)
+    {
+        if (F.is_finalized())
+            return F.get_csr();
+        F.pack_edges(local);
+        return local;
+    }
+
+    /// @brief Search of a bijection between the blocks of two functions
+    class IsomorphismSearch
+    {
+        const Function &A;
+        const Function &B;
+        const CSREdges &a_edges;
+        const CSREdges &b_edges;
+        std::span<const std::uint64_t> a_colors;
+        std::span<const std::uint64_t> b_colors;
+        /// @brief tag of B with the same string as each tag of A,
+        /// `missing` for the tags B does not have
+        std::vector<tag_id_t> tag_in_b;
+
+        std::vector<block_id_t> a_to_b;
+        std::vector<block_id_t> b_to_a;
+        /// @brief blocks of A in the order they were mapped, to undo
+        /// the mappings of a wrong choice
+        std::vector<block_id_t> trail;
+        /// @brief next block of the trail whose sucessors are not mapped
+        std::size_t propagated{0};
+
+    public:
+        static constexpr block_id_t none = ~block_id_t(0);
+        static constexpr tag_id_t missing = ~tag_id_t(0);
+
+        IsomorphismSearch(const Function &A, const Function &B, const CSREdges &a_edges, const CSREdges &b_edges,
+                          std::span<const std::uint64_t> a_colors, std::span<const std::uint64_t> b_colors)
+            : A(A), B(B), a_edges(a_edges), b_edges(b_edges), a_colors(a_colors), b_colors(b_colors),
+              a_to_b(a_colors.size(), none), b_to_a(b_colors.size(), none)
+        {
+            std::unordered_map<std::string_view, tag_id_t> b_tags;
+            for (tag_id_t id = 0; id < b_edges.tags.size(); id++)
+                b_tags.emplace(b_edges.tags.get(id), id);
+
+            tag_in_b.assign(a_edges.tags.size(), missing);
+            for (tag_id_t id = 0; id < a_edges.tags.size(); id++)
+                if (auto it = b_tags.find(a_edges.tags.get(id)); it != b_tags.end())
+                    tag_in_b[id] = it->second;
+        }
+
+        /// @brief Map `a` to `b`
+        /// @return false if it contradicts the mapping so far
+        bool assign(block_id_t a, block_id_t b)
+        {
+            if (a_to_b[a] != none || b_to_a[b] != none)
+                return a_to_b[a] == b;
+
+            /// the colors are hashes, the entry flag and the out degree are
+            /// checked directly so the result does not depend on them
+            if (a_colors[a] != b_colors[b] ||
+                A.get_basic_block(a)->get_entry_block() != B.get_basic_block(b)->get_entry_block() ||
+                a_edges.succ_end(a) - a_edges.succ_begin(a) != b_edges.succ_end(b) - b_edges.succ_begin(b))
+                return false;
+
+            a_to_b[a] = b;
+            b_to_a[b] = a;
+            trail.push_back(a);
+            return true;
+        }
+
+        /// @brief Map the sucessors of the blocks mapped, each edge of A
+        /// goes to the edge of B with the same tag
+        /// @return false if an edge has no counterpart
+        bool propagate()
+        {
+            for (; propagated < trail.size(); propagated++)
+            {
+                auto a = trail[propagated];
+                auto b = a_to_b[a];
+
+                for (auto e = a_edges.succ_begin(a); e < a_edges.succ_end(a); e++)
+                {
+                    auto tag = tag_in_b[a_edges.succ_tags[e]];
+                    auto f = b_edges.succ_begin(b);
+                    while (f < b_edges.succ_end(b) && b_edges.succ_tags[f] != tag)
+                        f++;
+
+                    if (f == b_edges.succ_end(b) || !assign(a_edges.succ_targets[e], b_edges.succ_targets[f]))
+                        return false;
+                }
+            }
+            return true;
+        }
+
+        /// @brief Forget the mappings made after the trail had `size` blocks
+        void undo(std::size_t size)
+        {
+            while (trail.size() > size)
+            {
+                b_to_a[a_to_b[trail.back()]] = none;
+                a_to_b[trail.back()] = none;
+                trail.pop_back();
+            }
+            propagated = size;
+        }
+
+        /// @brief Map the blocks of A from `next` on, trying for the first
+        /// block not mapped every block of B with its color
+        /// @return true if every block was mapped
+        bool search(block_id_t next)
+        {
+            /// the ids of deleted blocks are left out of the mapping
+            while (next < a_to_b.size() && (a_to_b[next] != none || !A.get_basic_block(next)))
+                next++;
+            if (next == a_to_b.size())
+                return true;
+
+            auto size = trail.size();
+            for (block_id_t b = 0; b < b_to_a.size(); b++)
+            {
+                if (b_to_a[b] != none || b_colors[b] != a_colors[next] || !B.get_basic_block(b))
+                    continue;
+
+                if (assign(next, b) && propagate() && search(next + 1))
+                    return true;
+                undo(size);
+            }
+            return false;
+        }
+
+        const std::vector<block_id_t> &get_mapping() const { return a_to_b; }
+    };
+} // namespace
+
+StructuralHash::StructuralHash(const Function &F)
+{
+    CSREdges local;
+    const auto &edges = get_edges(F, local);
+    const auto n = F.get_block_id_bound();
+
+    std::hash<std::string_view> hash_string;
+    std::vector<std::uint64_t> tag_hashes(edges.tags.size());
+    for (tag_id_t id = 0; id < tag_hashes.size(); id++)
+        tag_hashes[id] = mix(hash_string(edges.tags.get(id)));
+
+    /// the ids of deleted blocks have no edges and are left out of the hash
+    colors.resize(n);
+    for (block_id_t id = 0; id < n; id++)
+    {
+        if (!F.get_basic_block(id))
+            continue;
+        auto out_degree = edges.succ_end(id) - edges.succ_begin(id);
+        auto in_degree = edges.pred_end(id) - edges.pred_begin(id);
+        colors[id] = combine(combine(out_degree, in_degree), F.get_basic_block(id)->get_entry_block());
+    }
+
+    /// the colors of the neighbours are added, so their order does not
+    /// matter, and the direction of the edge is part of each term
+    std::vector<std::uint64_t> out_sum(n), in_sum(n);
+    for (unsigned round = 0; round < rounds; round++)
+    {
+        std::fill(out_sum.begin(), out_sum.end(), 0);
+        std::fill(in_sum.begin(), in_sum.end(), 0);
+
+        for (block_id_t src = 0; src < n; src++)
+            for (auto e = edges.succ_begin(src); e < edges.succ_end(src); e++)
+            {
+                auto dst = edges.succ_targets[e];
+                auto tag = tag_hashes[edges.succ_tags[e]];
+                out_sum[src] += combine(colors[dst], tag);
+                in_sum[dst] += combine(tag, colors[src]);
+            }
+
+        for (block_id_t id = 0; id < n; id++)
+            colors[id] = combine(combine(colors[id], out_sum[id]), in_sum[id]);
+    }
+
+    std::uint64_t sum = 0;
+    for (block_id_t id = 0; id < n; id++)
+        if (F.get_basic_block(id))
+            sum += mix(colors[id]);
+    hash = combine(combine(F.get_num_basic_blocks(), edges.num_edges()), sum);
+}
+
+bool CFG::is_isomorphic(const Function &A, const Function &B, std::vector<block_id_t> *mapping)
+{
+    const auto &a_hash = A.get_analysis<StructuralHash>();
+    const auto &b_hash = B.get_analysis<StructuralHash>();
+    if (a_hash.get_hash() != b_hash.get_hash() || A.get_num_basic_blocks() != B.get_num_basic_blocks())
+        return false;
+
+    CSREdges a_local, b_local;
+    const auto &a_edges = get_edges(A, a_local);
+    const auto &b_edges = get_edges(B, b_local);
+    if (a_edges.num_edges() != b_edges.num_edges())
+        return false;
+
+    /// with as many edges on both sides, mapping every edge of A to a
+    /// different edge of B maps all the edges of B too
+    IsomorphismSearch search(A, B, a_edges, b_edges, a_hash.get_colors(), b_hash.get_colors());
+    if (!search.search(0))
+        return false;
+
+    if (mapping)
+        *mapping = search.get_mapping();
+    return true;
+}
+
+DedupIndex::DedupIndex(const Module &M, unsigned threads) : module(&M)
+{
+    /// the tables are indexed by function id, the live functions are
+    /// the ones hashed and compared
+    std::vector<const Function *> functions;
+    for (const auto &func : M.get_functions())
+        functions.push_back(func.get());
+    const auto n = functions.size();
+    count = n;
+
+    canonical.assign(M.get_function_id_bound(), 0);
+    hashes.assign(M.get_function_id_bound(), 0);
+
+    std::unique_ptr<ThreadPool> pool;
+    if (threads != 1 && n > 1)
+        pool = std::make_unique<ThreadPool>(threads);
+
+    auto run = [&](std::size_t count, auto fn)
+    {
+        if (pool)
+            pool->parallel_for(count, fn, std::max<std::size_t>(1, count / (pool->size() * 16)));
+        else
+            for (std::size_t i = 0; i < count; i++)
+                fn(i);
+    };
+
+    /// every function is only used by one task in each phase,
+    /// so the analysis caches are not shared
+    run(n, [&](std::size_t i)
+        { hashes[functions[i]->get_id()] = functions[i]->get_analysis<StructuralHash>().get_hash(); });
+
+    /// functions by hash, in module order inside each hash
+    std::vector<std::uint32_t> order(n);
+    for (std::size_t i = 0; i < n; i++)
+        order[i] = functions[i]->get_id();
+    std::stable_sort(order.begin(), order.end(), [&](std::uint32_t a, std::uint32_t b)
+                     { return hashes[a] < hashes[b]; });
+
+    std::vector<std::size_t> groups;
+    for (std::size_t i = 0; i < n; i++)
+        if (i == 0 || hashes[order[i]] != hashes[order[i - 1]])
+            groups.push_back(i);
+    groups.push_back(n);
+
+    run(groups.size() - 1, [&](std::size_t g)
+        {
+            /// the first function of each class in the group
+            std::vector<std::uint32_t> representatives;
+            for (auto i = groups[g]; i < groups[g + 1]; i++)
+            {
+                auto id = order[i];
+                auto rep = std::find_if(representatives.begin(), representatives.end(), [&](std::uint32_t r)
+                                        { return is_isomorphic(*M.get_function(r), *M.get_function(id)); });
+                if (rep != representatives.end())
+                    canonical[id] = *rep;
+                else
+                {
+                    canonical[id] = id;
+                    representatives.push_back(id);
+                }
+            } });
+
+    for (auto id : order)
+        if (canonical[id] == id)
+            classes++;
+}
+
+const Function *DedupIndex::get_canonical(const Function *F) const
+{
+    return module->get_function(canonical[F->get_id()]);
+}
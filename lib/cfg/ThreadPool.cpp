@@ -0,0 +1,139 @@
+#include "cfg/ThreadPool.hpp"
+
+using namespace CFG;
+
+namespace
+{
+    /// @brief pool of the current thread, if it is a worker
+    thread_local const ThreadPool *current_pool = nullptr;
+    /// @brief index of the current thread inside its pool
+    thread_local std::size_t current_index = 0;
+} // namespace
+
+ThreadPool::ThreadPool(unsigned threads)
+{
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+
+    for (unsigned i = 0; i < threads; i++)
+        queues.push_back(std::make_unique<Queue>());
+
+    for (unsigned i = 0; i < threads; i++)
+        workers.emplace_back(&ThreadPool::worker_loop, this, i);
+}
+
+ThreadPool::~ThreadPool()
+{
+    wait();
+
+    {
+        std::lock_guard<std::mutex> guard(wake_lock);
+        stopping = true;
+    }
+    wake.notify_all();
+
+    for (auto &worker : workers)
+        worker.join();
+}
+
+void ThreadPool::submit(task_t task)
+{
+    std::size_t index;
+
+    if (current_pool == this)
+        index = current_index;
+    else
+        index = next_queue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+
+    pending.fetch_add(1);
+
+    {
+        std::lock_guard<std::mutex> guard(queues[index]->lock);
+        queues[index]->tasks.push_back(std::move(task));
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(wake_lock);
+        queued.fetch_add(1);
+    }
+    wake.notify_one();
+}
+
+bool ThreadPool::try_run(std::size_t self)
+{
+    task_t task;
+
+    for (std::size_t i = 0; i < queues.size() && !task; i++)
+    {
+        auto &queue = *queues[(self + i) % queues.size()];
+
+        std::lock_guard<std::mutex> guard(queue.lock);
+        if (queue.tasks.empty())
+            continue;
+
+        /// own work is taken LIFO, stolen work FIFO
+        if (i == 0)
+        {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        }
+        else
+        {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        }
+        queued.fetch_sub(1);
+    }
+
+    if (!task)
+        return false;
+
+    task();
+
+    if (pending.fetch_sub(1) == 1)
+    {
+        std::lock_guard<std::mutex> guard(wake_lock);
+        done.notify_all();
+    }
+
+    return true;
+}
+
+void ThreadPool::worker_loop(std::size_t index)
+{
+    current_pool = this;
+    current_index = index;
+
+    while (true)
+    {
+        if (try_run(index))
+            continue;
+
+        std::unique_lock<std::mutex> lock(wake_lock);
+        wake.wait(lock, [this]()
+                  { return stopping || queued.load() > 0; });
+
+        if (stopping && queued.load() == 0)
+            return;
+    }
+}
+
+std::size_t ThreadPool::self_index() const
+{
+    return current_pool == this ? current_index : 0;
+}
+
+void ThreadPool::wait()
+{
+    auto self = self_index();
+
+    while (pending.load() > 0)
+    {
+        if (try_run(self))
+            continue;
+
+        std::unique_lock<std::mutex> lock(wake_lock);
+        done.wait(lock, [this]()
+                  { return pending.load() == 0 || queued.load() > 0; });
+    }
+}
@@ -0,0 +1,118 @@
+//--------------------------------------------------------------------*- C++ -*-
+// CFG: example of CFG
+//
+// @file bench_dataflow.cpp
+// @brief Bit vector dataflow solver against a round robin solver
+
+#include "cfg/Dataflow.hpp"
+#include "cfg/Module.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+
+namespace
+{
+    /// @brief Liveness solved by visiting the blocks in id order until
+    /// nothing changes, the textbook version the solver is compared to
+    std::vector<CFG::BitVector> round_robin_liveness(const CFG::Function &F, std::size_t bits, std::size_t &passes)
+    {
+        const auto &edges = F.get_csr();
+        const auto n = F.get_basic_blocks().size();
+        std::vector<CFG::BitVector> live_in(n, CFG::BitVector(bits));
+        CFG::BitVector live_out(bits);
+
+        bool changed = true;
+        for (passes = 0; changed; passes++)
+        {
+            changed = false;
+            for (CFG::block_id_t b = 0; b < n; b++)
+            {
+                live_out.clear();
+                for (auto e = edges.succ_begin(b); e < edges.succ_end(b); e++)
+                    live_out.union_with(live_in[edges.succ_targets[e]]);
+
+                auto bb = F.get_basic_block(b);
+                changed |= live_in[b].assign_transfer(live_out, bb->get_gen(), bb->get_kill());
+            }
+        }
+
+        return live_in;
+    }
+} // namespace
+
+int
+main(int argc, char **argv)
+{
+    std::size_t max_blocks = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 40000;
+    std::size_t bits = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1024;
+
+    std::cout << "bits=" << bits << " simd=" << (CFG::BitVector::simd_enabled() ? "avx2" : "scalar") << "\n";
+
+    std::mt19937_64 rng(1234);
+
+    for (std::size_t num_blocks = 10000; num_blocks <= max_blocks; num_blocks *= 2)
+    {
+        std::unique_ptr<CFG::Module> M = std::make_unique<CFG::Module>("bench");
+        auto Fn = CFG::Function::Create("F", M.get());
+
+        /// a chain of blocks with random forward jumps and back edges,
+        /// every block uses and defines a few random variables
+        std::vector<CFG::BasicBlock *> blocks;
+        for (std::size_t b = 0; b < num_blocks; b++)
+        {
+            auto bb = CFG::BasicBlock::Create("BB" + std::to_string(b), Fn);
+            bb->get_gen().resize(bits);
+            bb->get_kill().resize(bits);
+            for (int v = 0; v < 4; v++)
+            {
+                bb->get_gen().set(rng() % bits);
+                bb->get_kill().set(rng() % bits);
+            }
+            blocks.push_back(bb);
+        }
+
+        for (std::size_t b = 1; b < num_blocks; b++)
+        {
+            Fn->add_sucessor(blocks[b - 1], blocks[b], "fallthrough");
+            auto target = b + rng() % 16;
+            if (target < num_blocks)
+                Fn->add_sucessor(blocks[b - 1], blocks[target], "jump");
+            if (rng() % 8 == 0)
+                Fn->add_sucessor(blocks[b], blocks[b - 1 - rng() % std::min<std::size_t>(b, 64)], "loop");
+        }
+
+        Fn->finalize();
+
+        auto start = std::chrono::steady_clock::now();
+        CFG::DataflowResult<CFG::LivenessProblem> live(*Fn, CFG::LivenessProblem(*Fn, bits));
+        auto end = std::chrono::steady_clock::now();
+        double solver_ms = std::chrono::duration<double, std::milli>(end - start).count();
+
+        std::size_t naive_passes = 0;
+        start = std::chrono::steady_clock::now();
+        auto expected = round_robin_liveness(*Fn, bits, naive_passes);
+        end = std::chrono::steady_clock::now();
+        double naive_ms = std::chrono::duration<double, std::milli>(end - start).count();
+
+        start = std::chrono::steady_clock::now();
+        CFG::DataflowResult<CFG::ReachingDefinitionsProblem> reaching(*Fn, CFG::ReachingDefinitionsProblem(*Fn, bits));
+        end = std::chrono::steady_clock::now();
+        double reaching_ms = std::chrono::duration<double, std::milli>(end - start).count();
+
+        std::size_t mismatches = 0;
+        for (CFG::block_id_t b = 0; b < num_blocks; b++)
+            if (!(live.get_out(b) == expected[b]))
+                mismatches++;
+
+        std::cout << "blocks=" << num_blocks << " liveness=" << solver_ms << "ms passes=" << live.get_passes()
+                  << " visits=" << live.get_visits() << " round-robin=" << naive_ms << "ms passes=" << naive_passes
+                  << " reaching-definitions=" << reaching_ms << "ms passes=" << reaching.get_passes()
+                  << " mismatches=" << mismatches << "\n";
+    }
+
+    return 0;
+}
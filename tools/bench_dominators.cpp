@@ -0,0 +1,111 @@
+//--------------------------------------------------------------------*- C++ -*-
+// CFG: example of CFG
+//
+// @file bench_dominators.cpp
+// @brief DominatorTree against a naive iterative dataflow on synthetic CFGs
+
+#include "cfg/Module.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+
+namespace
+{
+    /// @brief Dominator sets computed with the classic iterative
+    /// dataflow Dom(n) = {n} U (intersection of Dom(p) for p in preds(n)),
+    /// one bitset of n bits per block
+    std::vector<std::vector<std::uint64_t>> naive_dominators(const CFG::CSREdges &edges, CFG::block_id_t entry)
+    {
+        const auto n = edges.num_blocks();
+        const auto words = (n + 63) / 64;
+
+        std::vector<std::vector<std::uint64_t>> dom(n, std::vector<std::uint64_t>(words, ~std::uint64_t(0)));
+        dom[entry].assign(words, 0);
+        dom[entry][entry / 64] |= std::uint64_t(1) << (entry % 64);
+
+        std::vector<std::uint64_t> tmp(words);
+        bool changed = true;
+
+        while (changed)
+        {
+            changed = false;
+            for (CFG::block_id_t b = 0; b < n; b++)
+            {
+                if (b == entry)
+                    continue;
+
+                tmp.assign(words, ~std::uint64_t(0));
+                for (auto p = edges.pred_begin(b); p < edges.pred_end(b); p++)
+                    for (std::size_t w = 0; w < words; w++)
+                        tmp[w] &= dom[edges.pred_sources[p]][w];
+                tmp[b / 64] |= std::uint64_t(1) << (b % 64);
+
+                if (tmp != dom[b])
+                {
+                    dom[b].swap(tmp);
+                    changed = true;
+                }
+            }
+        }
+
+        return dom;
+    }
+} // namespace
+
+int
+main(int argc, char **argv)
+{
+    std::size_t max_blocks = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 20000;
+
+    std::mt19937_64 rng(1234);
+
+    for (std::size_t num_blocks = 1000; num_blocks <= max_blocks; num_blocks *= 2)
+    {
+        std::unique_ptr<CFG::Module> M = std::make_unique<CFG::Module>("bench");
+        auto Fn = CFG::Function::Create("F", M.get());
+
+        /// a chain of blocks with random forward jumps
+        /// and a few back edges creating loops
+        std::vector<CFG::BasicBlock *> blocks;
+        for (std::size_t b = 0; b < num_blocks; b++)
+            blocks.push_back(CFG::BasicBlock::Create("BB" + std::to_string(b), Fn));
+
+        for (std::size_t b = 1; b < num_blocks; b++)
+        {
+            Fn->add_sucessor(blocks[b - 1], blocks[b], "fallthrough");
+            auto target = b + rng() % 16;
+            if (target < num_blocks)
+                Fn->add_sucessor(blocks[b - 1], blocks[target], "jump");
+            if (rng() % 8 == 0)
+                Fn->add_sucessor(blocks[b], blocks[rng() % b], "loop");
+        }
+
+        Fn->finalize();
+
+        auto start = std::chrono::steady_clock::now();
+        CFG::DominatorTree tree(*Fn);
+        auto end = std::chrono::steady_clock::now();
+        double fast_ms = std::chrono::duration<double, std::milli>(end - start).count();
+
+        start = std::chrono::steady_clock::now();
+        auto sets = naive_dominators(Fn->get_csr(), 0);
+        end = std::chrono::steady_clock::now();
+        double naive_ms = std::chrono::duration<double, std::milli>(end - start).count();
+
+        /// both must agree on every pair of blocks
+        std::size_t mismatches = 0;
+        for (CFG::block_id_t a = 0; a < num_blocks; a++)
+            for (CFG::block_id_t b = 0; b < num_blocks; b++)
+                if (tree.dominates(a, b) != bool((sets[b][a / 64] >> (a % 64)) & 1))
+                    mismatches++;
+
+        std::cout << "blocks=" << num_blocks << " lengauer-tarjan=" << fast_ms << "ms naive=" << naive_ms
+                  << "ms speedup=" << naive_ms / fast_ms << " mismatches=" << mismatches << "\n";
+    }
+
+    return 0;
+}
@@ -0,0 +1,74 @@
+//--------------------------------------------------------------------*- C++ -*-
+// CFG: example of CFG
+//
+// @file bench_validate.cpp
+// @brief Scaling of Module::validate_all with the number of threads
+
+#include "cfg/Module.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+
+int
+main(int argc, char **argv)
+{
+    std::size_t num_functions = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 20000;
+    std::size_t num_blocks = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 64;
+
+    std::unique_ptr<CFG::Module> M = std::make_unique<CFG::Module>("bench");
+
+    std::mt19937_64 rng(42);
+
+    /// every function is a chain of blocks plus some random forward
+    /// and backward edges, so all blocks are reachable
+    for (std::size_t f = 0; f < num_functions; f++)
+    {
+        auto Fn = CFG::Function::Create("F" + std::to_string(f), M.get());
+
+        std::vector<CFG::BasicBlock *> blocks;
+        for (std::size_t b = 0; b < num_blocks; b++)
+            blocks.push_back(CFG::BasicBlock::Create("BB" + std::to_string(b), Fn));
+
+        for (std::size_t b = 1; b < num_blocks; b++)
+        {
+            Fn->add_sucessor(blocks[b - 1], blocks[b], "fallthrough");
+            Fn->add_sucessor(blocks[b - 1], blocks[rng() % num_blocks], "jump");
+        }
+    }
+
+    unsigned max_threads = std::max(1u, std::thread::hardware_concurrency());
+
+    std::cout << "functions=" << num_functions << " blocks=" << num_blocks << "\n";
+
+    double base = 0;
+
+    for (unsigned threads = 1; threads <= max_threads; threads *= 2)
+    {
+        /// changing the entry drops the reachability kept by each function,
+        /// so every run checks the whole graphs instead of the cached result
+        for (const auto &Fn : M->get_functions())
+        {
+            auto entry = Fn->get_basic_block(CFG::block_id_t(0));
+            entry->set_entry_block(false);
+            entry->set_entry_block(true);
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        auto report = M->validate_all(threads);
+        auto end = std::chrono::steady_clock::now();
+
+        double ms = std::chrono::duration<double, std::milli>(end - start).count();
+        if (threads == 1)
+            base = ms;
+
+        std::cout << "threads=" << threads << " time=" << ms << "ms speedup=" << base / ms
+                  << " errors=" << report.diagnostics.size() << "\n";
+    }
+
+    return 0;
+}
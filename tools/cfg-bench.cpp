@@ -0,0 +1,325 @@
+//--------------------------------------------------------------------*- C++ -*-
+// CFG: example of CFG
+//
+// @file cfg-bench.cpp
+// @brief Google Benchmark suite over generated graphs of every shape, from
+// 10 to 10M blocks. Results are written as JSON with the usual options:
+//
+//     cfg-bench --benchmark_format=json
+//     cfg-bench --benchmark_out=results.json --benchmark_out_format=json
+//
+// The environment variable CFG_BENCH_MAX_BLOCKS limits the biggest graph,
+// the 10M block graphs need several GB of memory. CFG_BENCH_STATS turns on
+// the timers of the operations when the library is built with them.
+
+#include "cfg/Exporter.hpp"
+#include "cfg/Generator.hpp"
+#include "cfg/GraphKernel.hpp"
+#include "cfg/Stats.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <charconv>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <random>
+#include <utility>
+
+#include <malloc.h>
+
+namespace
+{
+    constexpr std::uint64_t seed = 42;
+
+    /// @brief the timers are turned on before any benchmark runs
+    const bool stats_enabled = []
+    {
+        CFG::Stats::set_enabled(std::getenv("CFG_BENCH_STATS") != nullptr);
+        return CFG::Stats::is_enabled();
+    }();
+
+    const CFG::GeneratedGraph &get_graph(const benchmark::State &state)
+    {
+        static std::map<std::pair<std::int64_t, std::int64_t>, CFG::GeneratedGraph> cache;
+
+        auto key = std::make_pair(state.range(0), state.range(1));
+        auto it = cache.find(key);
+        if (it == cache.end())
+            it = cache.emplace(key, CFG::generate_graph(static_cast<CFG::GraphShape>(key.first), key.second, seed)).first;
+        return it->second;
+    }
+
+    void set_label(benchmark::State &state)
+    {
+        state.SetLabel(std::string(CFG::shape_name(static_cast<CFG::GraphShape>(state.range(0)))));
+    }
+
+    /// @brief bytes taken from the heap, both from the malloc arenas
+    /// and mapped directly
+    std::size_t heap_in_use()
+    {
+        auto info = mallinfo2();
+        return info.uordblks + info.hblkhd;
+    }
+
+    /// @brief Sink that only counts the bytes
+    class NullSink : public CFG::OutputSink
+    {
+    public:
+        std::size_t bytes{0};
+
+        void write(const char *, std::size_t size) override { bytes += size; }
+    };
+
+    /// @brief sizes of the graphs go from 10 to 10M blocks, or
+    /// CFG_BENCH_MAX_BLOCKS, by factors of 100
+    std::int64_t max_blocks()
+    {
+        auto env = std::getenv("CFG_BENCH_MAX_BLOCKS");
+        return env ? std::strtoll(env, nullptr, 10) : 10000000;
+    }
+
+    /// @brief Arguments (shape, blocks) of the benchmarks over graphs
+    void all_shapes(benchmark::internal::Benchmark *b)
+    {
+        for (int shape = 0; shape <= static_cast<int>(CFG::GraphShape::Compiler); shape++)
+            for (std::int64_t blocks = 10; blocks <= max_blocks(); blocks *= 100)
+                b->Args({shape, blocks});
+        b->Unit(benchmark::kMicrosecond);
+    }
+
+    /// @brief Arguments of the benchmarks that do not use the edges
+    void sizes_only(benchmark::internal::Benchmark *b)
+    {
+        for (std::int64_t blocks = 10; blocks <= max_blocks(); blocks *= 100)
+            b->Args({0, blocks});
+        b->Unit(benchmark::kMicrosecond);
+    }
+} // namespace
+
+static void BM_CreateBlocks(benchmark::State &state)
+{
+    const auto n = state.range(1);
+    std::unique_ptr<CFG::Module> M;
+    char name[24] = "bb";
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        M = std::make_unique<CFG::Module>("bench");
+        auto Fn = CFG::Function::Create("F", M.get());
+        state.ResumeTiming();
+
+        for (std::int64_t i = 0; i < n; i++)
+        {
+            auto end = std::to_chars(name + 2, name + sizeof(name), i).ptr;
+            benchmark::DoNotOptimize(CFG::BasicBlock::Create(std::string_view(name, end - name), Fn));
+        }
+
+        state.PauseTiming();
+        M.reset();
+        state.ResumeTiming();
+    }
+
+    state.SetItemsProcessed(state.iterations() * n);
+}
+
+static void BM_AddSucessor(benchmark::State &state)
+{
+    const auto &G = get_graph(state);
+    CFG::GeneratedGraph blocks_only{G.num_blocks, {}, G.tags};
+    std::unique_ptr<CFG::Module> M;
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        M = std::make_unique<CFG::Module>("bench");
+        auto Fn = CFG::build_function(blocks_only, M.get(), "F");
+        state.ResumeTiming();
+
+        for (const auto &edge : G.edges)
+            Fn->add_sucessor(Fn->get_basic_block(edge.src), Fn->get_basic_block(edge.dst), G.get_tag(edge));
+
+        state.PauseTiming();
+        M.reset();
+        state.ResumeTiming();
+    }
+
+    set_label(state);
+    state.SetItemsProcessed(state.iterations() * G.edges.size());
+}
+
+static void BM_AddSuccessorsBatch(benchmark::State &state)
+{
+    const auto &G = get_graph(state);
+    CFG::GeneratedGraph blocks_only{G.num_blocks, {}, G.tags};
+    std::unique_ptr<CFG::Module> M;
+    std::vector<CFG::Function::Edge> edges;
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        M = std::make_unique<CFG::Module>("bench");
+        auto Fn = CFG::build_function(blocks_only, M.get(), "F");
+        edges.clear();
+        for (const auto &edge : G.edges)
+            edges.push_back({Fn->get_basic_block(edge.src), Fn->get_basic_block(edge.dst), G.get_tag(edge)});
+        state.ResumeTiming();
+
+        Fn->add_successors(edges);
+
+        state.PauseTiming();
+        M.reset();
+        state.ResumeTiming();
+    }
+
+    set_label(state);
+    state.SetItemsProcessed(state.iterations() * G.edges.size());
+}
+
+static void BM_DeleteBasicBlock(benchmark::State &state)
+{
+    const auto &G = get_graph(state);
+    std::unique_ptr<CFG::Module> M;
+    std::vector<CFG::BasicBlock *> victims;
+    std::mt19937_64 rng(seed);
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        M = std::make_unique<CFG::Module>("bench");
+        auto Fn = CFG::build_function(G, M.get(), "F");
+
+        /// a tenth of the blocks, never the entry
+        victims.clear();
+        for (const auto &bb : Fn->get_basic_blocks())
+            if (bb->get_id() != 0)
+                victims.push_back(bb.get());
+        std::shuffle(victims.begin(), victims.end(), rng);
+        victims.resize(std::max<std::size_t>(victims.size() / 10, std::min<std::size_t>(victims.size(), 1)));
+        state.ResumeTiming();
+
+        for (auto bb : victims)
+            Fn->delete_basic_block(bb);
+
+        state.PauseTiming();
+        M.reset();
+        state.ResumeTiming();
+    }
+
+    set_label(state);
+    state.SetItemsProcessed(state.iterations() * victims.size());
+}
+
+static void BM_ValidateFunction(benchmark::State &state)
+{
+    const auto &G = get_graph(state);
+    auto M = std::make_unique<CFG::Module>("bench");
+    auto Fn = CFG::build_function(G, M.get(), "F");
+    auto entry = Fn->get_basic_block(CFG::block_id_t(0));
+
+    for (auto _ : state)
+    {
+        /// changing the entry drops the reachability, so
+        /// every validation checks the whole graph
+        entry->set_entry_block(false);
+        entry->set_entry_block(true);
+        Fn->validate_function();
+    }
+
+    set_label(state);
+    state.SetItemsProcessed(state.iterations() * G.num_blocks);
+}
+
+static void BM_ExportDot(benchmark::State &state)
+{
+    const auto &G = get_graph(state);
+    auto M = std::make_unique<CFG::Module>("bench");
+    auto Fn = CFG::build_function(G, M.get(), "F");
+    NullSink sink;
+
+    for (auto _ : state)
+    {
+        CFG::OutputBuffer out(sink);
+        CFG::export_function(*Fn, out, CFG::ExportFormat::Dot);
+    }
+
+    set_label(state);
+    state.SetBytesProcessed(sink.bytes);
+    state.SetItemsProcessed(state.iterations() * G.num_blocks);
+}
+
+/// @brief Build a whole function, reporting the memory it takes
+static void BM_BuildFunction(benchmark::State &state)
+{
+    const auto &G = get_graph(state);
+    std::unique_ptr<CFG::Module> M;
+    std::size_t heap = 0, arena = 0;
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        M.reset();
+        auto before = heap_in_use();
+        M = std::make_unique<CFG::Module>("bench");
+        state.ResumeTiming();
+
+        CFG::build_function(G, M.get(), "F");
+
+        state.PauseTiming();
+        heap = heap_in_use() - before;
+        arena = M->get_arena().get_bytes_reserved();
+        state.ResumeTiming();
+    }
+
+    set_label(state);
+    state.SetItemsProcessed(state.iterations() * G.num_blocks);
+    state.counters["bytes_per_block"] = static_cast<double>(heap) / G.num_blocks;
+    state.counters["arena_bytes_per_block"] = static_cast<double>(arena) / G.num_blocks;
+}
+
+/// @brief Depth first search over a graph laid out by a storage policy
+template <typename Policy>
+static void BM_DepthFirst(benchmark::State &state)
+{
+    const auto &G = get_graph(state);
+    auto M = std::make_unique<CFG::Module>("bench");
+    auto Fn = CFG::build_function(G, M.get(), "F");
+    CFG::BasicGraph<Policy> graph;
+    if (graph.assign(*Fn))
+    {
+        state.SkipWithError("the graph does not fit the policy");
+        return;
+    }
+
+    std::vector<typename Policy::index_t> order;
+    std::vector<bool> visited;
+    order.reserve(graph.size());
+
+    for (auto _ : state)
+    {
+        order.clear();
+        visited.assign(graph.size(), false);
+        CFG::depth_first_search(graph, graph.get_entry(), nullptr, &order, visited);
+        benchmark::DoNotOptimize(order.data());
+    }
+
+    set_label(state);
+    state.SetItemsProcessed(state.iterations() * G.num_blocks);
+}
+
+BENCHMARK(BM_CreateBlocks)->Apply(sizes_only);
+BENCHMARK(BM_AddSucessor)->Apply(all_shapes);
+BENCHMARK(BM_AddSuccessorsBatch)->Apply(all_shapes);
+BENCHMARK(BM_DeleteBasicBlock)->Apply(all_shapes);
+BENCHMARK(BM_ValidateFunction)->Apply(all_shapes);
+BENCHMARK(BM_ExportDot)->Apply(all_shapes);
+BENCHMARK(BM_BuildFunction)->Apply(all_shapes);
+BENCHMARK_TEMPLATE(BM_DepthFirst, CFG::DefaultGraphPolicy)->Apply(all_shapes);
+BENCHMARK_TEMPLATE(BM_DepthFirst, CFG::WideGraphPolicy)->Apply(all_shapes);
+/// random DAGs have at most two sucessors per block
+BENCHMARK_TEMPLATE(BM_DepthFirst, CFG::BranchGraphPolicy)->Apply(sizes_only);
+
+BENCHMARK_MAIN();
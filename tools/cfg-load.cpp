@@ -0,0 +1,78 @@
+//--------------------------------------------------------------------*- C++ -*-
+// CFG: example of CFG
+//
+// @file cfg-load.cpp
+// @brief Load a module written as edge list or JSON, report the time
+// spent and validate it. With --stats the statistics of the module are
+// written as JSON at the end.
+
+#include "cfg/Exporter.hpp"
+#include "cfg/Parser.hpp"
+#include "cfg/Stats.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+
+int
+main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        std::cerr << "usage: " << argv[0] << " <file> [threads] [--json|--edge-list] [--stats]\n";
+        return 1;
+    }
+
+    unsigned threads = 0;
+    CFG::InputFormat format = CFG::InputFormat::Auto;
+    bool stats = false;
+    for (int i = 2; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--json") == 0)
+            format = CFG::InputFormat::Json;
+        else if (std::strcmp(argv[i], "--edge-list") == 0)
+            format = CFG::InputFormat::EdgeList;
+        else if (std::strcmp(argv[i], "--stats") == 0)
+            stats = true;
+        else
+            threads = static_cast<unsigned>(std::strtoul(argv[i], nullptr, 10));
+    }
+
+    CFG::Stats::set_enabled(stats);
+
+    std::unique_ptr<CFG::Module> M;
+    auto start = std::chrono::steady_clock::now();
+    try
+    {
+        M = CFG::load_module(argv[1], format, threads);
+    }
+    catch (std::exception &e)
+    {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::size_t blocks = 0;
+    for (const auto &func : M->get_functions())
+        blocks += func->get_basic_blocks().size();
+
+    std::cout << "Loaded module \"" << M->get_name() << "\" with " << M->get_functions().size()
+              << " functions and " << blocks << " blocks in " << elapsed.count() * 1000 << " ms\n";
+
+    auto report = M->validate_all(threads);
+    std::cout << report;
+
+    if (stats)
+    {
+        CFG::StreamSink sink(std::cout);
+        CFG::OutputBuffer out(sink);
+        CFG::export_module_stats(*M, out);
+        out.write('\n');
+        out.flush();
+    }
+
+    return report.ok() ? 0 : 2;
+}
@@ -4,9 +4,13 @@
 // @file test1.cpp
 // @brief Test1 for testing simple Module, Function and BasicBlocks creation
 
+#include "cfg/Exporter.hpp"
+#include "cfg/Generator.hpp"
 #include "cfg/Module.hpp"
+#include "cfg/Stats.hpp"
 
 #include <memory>
+#include <sstream>
 
 int
 main()
@@ -19,8 +23,33 @@ main()
 
     auto BB2 = CFG::BasicBlock::Create("BB2", Fn);
 
+    BB1->set_start_addr(0x1000);
+    BB1->set_end_addr(0x1010);
+
+    BB2->set_start_addr(0x1010);
+    BB2->set_end_addr(0x1020);
+
     std::cout << *M;
 
+    /// lookups by address and by name
+    if (Fn->get_block_by_address(0x1014) == BB2 && Fn->get_block_by_address(0x1020) == nullptr &&
+        Fn->get_basic_block("BB1") == BB1 && M->get_function("Func1") == Fn)
+        std::cout << "Lookups passed\n";
+
+    /// instructions: BB1 gets a second batch after BB2, so its
+    /// slice is moved, and the lookup by address works in the slice
+    const CFG::operand_t ops[] = {1, 2};
+    BB1->add_instruction(1, 0x1000, ops);
+    BB1->add_instruction(2, 0x1004);
+    BB2->add_instruction(3, 0x1010, ops);
+    BB1->add_instruction(4, 0x1008);
+
+    auto insts = BB1->get_instructions();
+    auto split = Fn->get_instruction_buffer().lower_bound(insts.get_begin(), insts.get_end(), 0x1004);
+    if (insts.size() == 3 && insts[0].operands.size() == 2 && insts[0].operands[1] == 2 && insts[2].opcode == 4 &&
+        BB2->get_instructions()[0].address == 0x1010 && split == insts.get_begin() + 1)
+        std::cout << "Instructions passed\n";
+
     Fn->delete_basic_block("BB2");
 
     std::cout << *M;
@@ -29,5 +58,74 @@ main()
 
     std::cout << *M;
 
+    /// generated graphs are the same for the same seed and every
+    /// block is reachable from the entry
+    bool generated = true;
+    for (auto shape : {CFG::GraphShape::RandomDag, CFG::GraphShape::Loops, CFG::GraphShape::Switch, CFG::GraphShape::Compiler})
+    {
+        for (std::size_t blocks : {1, 10, 1000})
+        {
+            auto G = CFG::generate_graph(shape, blocks, 7);
+            auto again = CFG::generate_graph(shape, blocks, 7);
+            generated = generated && G.edges.size() == again.edges.size() &&
+                        std::equal(G.edges.begin(), G.edges.end(), again.edges.begin(), [](const auto &a, const auto &b)
+                                   { return a.src == b.src && a.dst == b.dst && a.tag == b.tag; });
+
+            auto F = CFG::build_function(G, M.get(), CFG::shape_name(shape));
+            try
+            {
+                F->validate_function();
+            }
+            catch (std::exception &e)
+            {
+                generated = false;
+            }
+            /// all the edges were added, the tags of a block are unique
+            CFG::CSREdges edges;
+            F->pack_edges(edges);
+            generated = generated && edges.succ_targets.size() == G.edges.size() && F->get_basic_blocks().size() == blocks;
+        }
+    }
+    if (generated)
+        std::cout << "Generator passed\n";
+
+    /// shape and memory of a diamond, the timers only count when compiled in
+    CFG::Stats::reset();
+    CFG::Stats::set_enabled(true);
+    auto Diamond = CFG::Function::Create("Diamond", M.get());
+    auto Top = CFG::BasicBlock::Create("Top", Diamond);
+    auto Left = CFG::BasicBlock::Create("Left", Diamond);
+    auto Right = CFG::BasicBlock::Create("Right", Diamond);
+    auto Bottom = CFG::BasicBlock::Create("Bottom", Diamond);
+    Diamond->add_sucessor(Top, Left, "true");
+    Diamond->add_sucessor(Top, Right, "false");
+    Diamond->add_sucessor(Left, Bottom, "");
+    Diamond->add_sucessor(Right, Bottom, "");
+    Diamond->validate_function();
+    CFG::Stats::set_enabled(false);
+    Diamond->add_sucessor(Bottom, Top, "loop");
+
+    auto stats = CFG::collect_stats(*Diamond);
+    auto adds = CFG::Stats::get(CFG::StatOp::AddSucessor);
+    bool stats_ok = stats.blocks == 4 && stats.edges == 5 && stats.max_depth == 2 &&
+                    stats.out_degree == std::vector<std::size_t>{0, 3, 1} && stats.edge_bytes == 0 &&
+                    stats.block_bytes == 4 * sizeof(CFG::BasicBlock) &&
+                    adds.count == (CFG::Stats::compiled_in() ? 4 : 0) &&
+                    CFG::Stats::get(CFG::StatOp::ValidateFunction).count == adds.count / 4;
+
+    std::ostringstream json;
+    {
+        CFG::StreamSink sink(json);
+        CFG::OutputBuffer out(sink);
+        CFG::export_module_stats(*M, out);
+    }
+    stats_ok = stats_ok && json.str().find("{\"name\":\"Diamond\",\"blocks\":4,\"edges\":5,\"max_depth\":2,\"out_degree\":[0,3,1]") != std::string::npos &&
+               json.str().find("\"add_sucessor\":{\"count\":" + std::to_string(adds.count)) != std::string::npos;
+
+    if (stats_ok)
+        std::cout << "Stats passed\n";
+    else
+        std::cout << "Stats FAILED\n";
+
     return 0;
 }
\ No newline at end of file
@@ -9,6 +9,8 @@
 #include <iostream>
 #include <fstream>
 #include <memory>
+#include <string>
+#include <vector>
 
 int
 main()
@@ -71,5 +73,157 @@ main()
 
     ofs.close();
 
+    /// pack the edges, the graph must be the same
+    Fn->finalize();
+
+    ofs.open("graph4.dot");
+
+    Fn->dump_function_dot(ofs);
+
+    std::cout << "graph4.dot generated from the finalized function\n";
+
+    ofs.close();
+
+    /// jump table added in a single batch, with a repeated case and
+    /// a tag already used by the source
+    auto Fn2 = CFG::Function::Create("Func2", M.get());
+    auto Switch = CFG::BasicBlock::Create("Switch", Fn2);
+    std::vector<std::string> cases;
+    cases.reserve(1000);
+    std::vector<CFG::Function::Edge> table;
+    Fn2->add_sucessor(Switch, Switch, "default");
+    for (int i = 0; i < 1000; i++)
+    {
+        cases.push_back("case " + std::to_string(i));
+        table.push_back({Switch, CFG::BasicBlock::Create(cases.back(), Fn2), cases.back()});
+    }
+    table.push_back({Switch, Switch, "case 7"});
+    table.push_back({Switch, Switch, "default"});
+
+    bool skipped = Fn2->add_successors(table);
+    Fn2->finalize();
+    const auto &csr = Fn2->get_csr();
+    bool same_order = csr.succ_end(0) - csr.succ_begin(0) == 1001;
+    for (int i = 0; same_order && i < 1000; i++)
+        same_order = csr.succ_targets[csr.succ_begin(0) + 1 + i] == static_cast<CFG::block_id_t>(i + 1) &&
+                     csr.tags.get(csr.succ_tags[csr.succ_begin(0) + 1 + i]) == cases[i];
+
+    Fn2->validate_function();
+    if (skipped && same_order && Fn2->get_dominator_tree().get_idom(1000) == 0)
+        std::cout << "Batch of sucessors passed\n";
+    else
+        std::cout << "Batch of sucessors FAILED\n";
+
+    /// split a block with a loop back to it and merge it again
+    auto Fn3 = CFG::Function::Create("Func3", M.get());
+    auto Head = CFG::BasicBlock::Create("Head", Fn3);
+    auto Then = CFG::BasicBlock::Create("Then", Fn3);
+    auto Else = CFG::BasicBlock::Create("Else", Fn3);
+    Head->set_start_addr(0x1000);
+    Head->set_end_addr(0x1040);
+    for (std::uint64_t addr = 0x1000; addr < 0x1040; addr += 0x10)
+        Head->add_instruction(1, addr);
+    Fn3->add_sucessor(Head, Then, "true");
+    Fn3->add_sucessor(Head, Else, "false");
+    Fn3->add_sucessor(Then, Head, "loop");
+
+    auto Tail = Fn3->split_block(Head, 0x1020, "Tail");
+    CFG::CSREdges edges;
+    Fn3->pack_edges(edges);
+    auto tail_id = Tail->get_id();
+    bool split_ok = Fn3->split_block(Head, 0x1020) == nullptr &&
+                    Head->get_end_addr() == 0x1020 && Tail->get_end_addr() == 0x1040 &&
+                    Fn3->get_block_by_address(0x1028) == Tail &&
+                    Head->get_instructions().size() == 2 && Tail->get_instructions()[0].address == 0x1020 &&
+                    edges.succ_end(0) - edges.succ_begin(0) == 1 && edges.succ_targets[edges.succ_begin(0)] == tail_id &&
+                    edges.succ_end(tail_id) - edges.succ_begin(tail_id) == 2 &&
+                    edges.pred_end(0) - edges.pred_begin(0) == 1 && edges.pred_sources[edges.pred_begin(0)] == Then->get_id();
+    Fn3->validate_function();
+
+    bool merge_ok = Fn3->merge_blocks(Head, Then) && !Fn3->merge_blocks(Head, Tail) &&
+                    Fn3->get_basic_blocks().size() == 3 && Head->get_end_addr() == 0x1040 &&
+                    Head->get_instructions().size() == 4 && Fn3->get_block_by_address(0x1028) == Head;
+    Fn3->pack_edges(edges);
+    merge_ok = merge_ok && edges.succ_end(0) - edges.succ_begin(0) == 2 &&
+               edges.succ_targets[edges.succ_begin(0)] == Then->get_id();
+    Fn3->validate_function();
+
+    /// a chain of blocks collapses into its head
+    auto Fn4 = CFG::Function::Create("Func4", M.get());
+    auto Prev = CFG::BasicBlock::Create("Chain0", Fn4);
+    for (int i = 1; i < 100; i++)
+    {
+        auto Next = CFG::BasicBlock::Create("Chain" + std::to_string(i), Fn4);
+        Next->add_instruction(1, i);
+        Fn4->add_sucessor(Prev, Next, "");
+        Prev = Next;
+    }
+    Fn4->add_sucessor(Prev, Prev, "loop");
+    bool collapse_ok = Fn4->collapse_chains() == 98 && Fn4->get_basic_blocks().size() == 2 &&
+                       (*Fn4->get_basic_blocks().begin())->get_instructions().size() == 98;
+    Fn4->validate_function();
+
+    if (split_ok && merge_ok && collapse_ok)
+        std::cout << "Split and merge passed\n";
+    else
+        std::cout << "Split and merge FAILED\n";
+
+    /// edges kept inline in the blocks and spilled by a switch
+    auto Fn5 = CFG::Function::Create("Func5", M.get());
+    auto Dispatch = CFG::BasicBlock::Create("Dispatch", Fn5);
+    auto Join = CFG::BasicBlock::Create("Join", Fn5);
+    std::vector<CFG::BasicBlock *> arms;
+    for (int i = 0; i < 6; i++)
+    {
+        arms.push_back(CFG::BasicBlock::Create("Case" + std::to_string(i), Fn5));
+        Fn5->add_sucessor(Dispatch, arms.back(), "case " + std::to_string(i));
+        Fn5->add_sucessor(arms.back(), Join, "");
+    }
+    /// deleted blocks leave their ids free, the rest keep their ids
+    /// and their order until the function is compacted
+    Fn5->delete_basic_block(arms[1]);
+    Fn5->delete_basic_block(arms[4]);
+    Fn5->delete_basic_block(Fn5->get_last_bb());
+    bool remap_ok = arms[2]->get_id() == 4 && arms[3]->get_id() == 5 &&
+                    Fn5->get_num_basic_blocks() == 5 && Fn5->get_block_id_bound() == 6 &&
+                    Fn5->get_last_bb() == arms[3] && Fn5->get_basic_block(CFG::block_id_t(3)) == nullptr;
+
+    /// a table indexed by block id kept in sync with the compaction
+    std::vector<std::string_view> by_id(Fn5->get_block_id_bound());
+    for (const auto &bb : Fn5->get_basic_blocks())
+        by_id[bb->get_id()] = bb->get_name();
+    Fn5->set_block_remap_callback([&](CFG::block_id_t old_id, CFG::block_id_t new_id)
+                                  { by_id[new_id] = by_id[old_id]; });
+    Fn5->compact();
+    Fn5->set_block_remap_callback(nullptr);
+    by_id.resize(Fn5->get_block_id_bound());
+
+    std::vector<std::string_view> names;
+    for (const auto &bb : Fn5->get_basic_blocks())
+    {
+        remap_ok = remap_ok && by_id[bb->get_id()] == bb->get_name();
+        names.push_back(bb->get_name());
+    }
+    remap_ok = remap_ok && by_id.size() == 5 && arms[3]->get_id() == 4 &&
+               names == std::vector<std::string_view>{"Dispatch", "Join", "Case0", "Case2", "Case3"};
+
+    names.clear();
+    for (auto bb : Fn5->successors(Dispatch))
+        names.push_back(bb->get_name());
+    bool inline_ok = remap_ok && names == std::vector<std::string_view>{"Case0", "Case2", "Case3"} &&
+                     Fn5->predecessors(Join).size() == 3;
+    Dispatch->set_end_addr(0x10);
+    auto Rest = Fn5->split_block(Dispatch, 0x8, "Rest");
+    inline_ok = inline_ok && Rest && Fn5->successors(Dispatch).size() == 1 && Fn5->successors(Rest).size() == 3 &&
+                *Fn5->predecessors(arms[3]).begin() == Rest;
+    Fn5->finalize();
+    inline_ok = inline_ok && Fn5->successors(Rest).size() == 3 && Fn5->predecessors(Join).size() == 3;
+    Fn5->validate_function();
+
+    if (inline_ok)
+        std::cout << "Inline edges passed\n";
+    else
+        std::cout << "Inline edges FAILED\n";
+
     return 0;
 }
\ No newline at end of file
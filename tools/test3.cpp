@@ -5,6 +5,8 @@
 // @brief Test3 for testing validation of function control flow graph
 
 #include "cfg/Module.hpp"
+#include "cfg/ModuleBuilder.hpp"
+#include "cfg/ThreadPool.hpp"
 
 #include <iostream>
 #include <fstream>
@@ -85,4 +87,40 @@ main()
     {
         std::cerr << e.what() << "\n";
     }
-}
\ No newline at end of file
+
+    /// all the functions at once, every error is reported
+    std::cout << M->validate_all(2);
+
+    /// functions built from several threads at once, every other
+    /// function has a block not connected to the rest
+    std::unique_ptr<CFG::Module> M2 = std::make_unique<CFG::Module>("concurrent");
+    CFG::ModuleBuilder builder(*M2);
+    {
+        CFG::ThreadPool pool(4);
+        pool.parallel_for(200, [&](std::size_t i)
+                          {
+                              auto Fn = builder.get_worker().create_function("F" + std::to_string(i), i);
+                              auto Prev = CFG::BasicBlock::Create("Entry", Fn);
+                              for (int b = 0; b < 20; b++)
+                              {
+                                  auto Next = CFG::BasicBlock::Create("B" + std::to_string(b), Fn);
+                                  if (i % 2 == 0 || b != 10)
+                                      Fn->add_sucessor(Prev, Next, "");
+                                  Prev = Next;
+                              } });
+    }
+    builder.freeze(4);
+
+    bool in_order = M2->get_functions().size() == 200;
+    for (std::size_t i = 0; in_order && i < 200; i++)
+    {
+        auto Fn = M2->get_function(static_cast<std::uint32_t>(i));
+        in_order = Fn->get_name() == "F" + std::to_string(i) && Fn->get_id() == i && Fn->is_finalized() &&
+                   M2->get_function(Fn->get_name()) == Fn && Fn->get_basic_blocks().size() == 21;
+    }
+
+    if (in_order && M2->validate_all(4).diagnostics.size() == 100)
+        std::cout << "Concurrent build passed\n";
+    else
+        std::cout << "Concurrent build FAILED\n";
+}
@@ -0,0 +1,413 @@
+//--------------------------------------------------------------------*- C++ -*-
+// CFG: example of CFG
+//
+// @file test4.cpp
+// @brief Test4 for testing the analyses over the control flow graph
+
+#include "cfg/CallGraph.hpp"
+#include "cfg/Dataflow.hpp"
+#include "cfg/Generator.hpp"
+#include "cfg/GraphKernel.hpp"
+#include "cfg/Module.hpp"
+#include "cfg/StructuralHash.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <ranges>
+#include <vector>
+
+int
+main()
+{
+    std::unique_ptr<CFG::Module> M = std::make_unique<CFG::Module>("test4");
+
+    /// Entry -> H, I -> J -> K -> J (loop), K -> Exit
+    auto Fn = CFG::Function::Create("Func1", M.get());
+    auto Entry = CFG::BasicBlock::Create("Entry", Fn);
+    auto H = CFG::BasicBlock::Create("H", Fn);
+    auto I = CFG::BasicBlock::Create("I", Fn);
+    auto J = CFG::BasicBlock::Create("J", Fn);
+    auto K = CFG::BasicBlock::Create("K", Fn);
+    auto Exit = CFG::BasicBlock::Create("Exit", Fn);
+    Fn->add_sucessor(Entry, H, "true");
+    Fn->add_sucessor(Entry, I, "false");
+    Fn->add_sucessor(H, J, "");
+    Fn->add_sucessor(I, J, "");
+    Fn->add_sucessor(J, K, "");
+    Fn->add_sucessor(K, J, "loop");
+    Fn->add_sucessor(K, Exit, "exit");
+
+    const auto &dom = Fn->get_dominator_tree();
+
+    for (const auto &bb : Fn->get_basic_blocks())
+    {
+        auto idom = dom.get_idom(bb->get_id());
+        std::cout << "idom(" << bb->get_name() << ") = "
+                  << (idom == CFG::DominatorTree::invalid ? "none" : Fn->get_basic_block(idom)->get_name()) << "\n";
+    }
+
+    auto [df_begin, df_end] = dom.get_frontier(H->get_id());
+    if (dom.dominates(Entry, Exit) && !dom.dominates(H, J) && df_end - df_begin == 1 && *df_begin == J->get_id())
+        std::cout << "Dominators passed\n";
+
+    /// back edges into the entry block: 0 -> 1, 0 -> 2, 1 -> 2, 2 -> 0,
+    /// 2 -> 1, and an entry block with only a self loop
+    auto FnBack = CFG::Function::Create("FuncBack", M.get());
+    std::vector<CFG::BasicBlock *> back;
+    for (int i = 0; i < 3; i++)
+        back.push_back(CFG::BasicBlock::Create("B" + std::to_string(i), FnBack));
+    FnBack->add_sucessor(back[0], back[1], "true");
+    FnBack->add_sucessor(back[0], back[2], "false");
+    FnBack->add_sucessor(back[1], back[2], "");
+    FnBack->add_sucessor(back[2], back[0], "true");
+    FnBack->add_sucessor(back[2], back[1], "false");
+
+    auto FnSelf = CFG::Function::Create("FuncSelf", M.get());
+    auto Self = CFG::BasicBlock::Create("Self", FnSelf);
+    CFG::BasicBlock::Create("Next", FnSelf);
+    FnSelf->add_sucessor(Self, Self, "loop");
+    FnSelf->add_sucessor(Self, FnSelf->get_basic_block(CFG::block_id_t(1)), "exit");
+
+    auto frontier = [](const CFG::DominatorTree &tree, CFG::block_id_t id)
+    {
+        auto [begin, end] = tree.get_frontier(id);
+        std::vector<CFG::block_id_t> out(begin, end);
+        std::ranges::sort(out);
+        return out;
+    };
+    const auto &dom_back = FnBack->get_dominator_tree();
+    const auto &dom_self = FnSelf->get_dominator_tree();
+    if (frontier(dom_back, 2) == std::vector<CFG::block_id_t>{0, 1} &&
+        frontier(dom_back, 1) == std::vector<CFG::block_id_t>{2} &&
+        frontier(dom_back, 0) == std::vector<CFG::block_id_t>{0} &&
+        frontier(dom_self, 0) == std::vector<CFG::block_id_t>{0} && frontier(dom_self, 1).empty())
+        std::cout << "Entry frontiers passed\n";
+    else
+        std::cout << "Entry frontiers FAILED\n";
+    M->delete_function(FnSelf);
+    M->delete_function(FnBack);
+
+    const auto &pdom = Fn->get_post_dominator_tree();
+    if (pdom.dominates(J, Entry) && pdom.dominates(Exit, H) && !pdom.dominates(H, Entry))
+        std::cout << "Post-dominators passed\n";
+
+    const auto &loops = Fn->get_loop_info();
+    if (loops.get_loops().size() == 1 && loops.is_loop_header(J->get_id()) && loops.get_loop_depth(K) == 1 &&
+        loops.get_loop_depth(Exit) == 0 && loops.get_back_edges().size() == 1)
+        std::cout << "Loops passed\n";
+
+    /// a failed modification keeps the cache, a real one makes it stale
+    auto epoch = Fn->get_epoch();
+    Fn->add_sucessor(Entry, K, "true");
+    if (Fn->get_epoch() == epoch && Fn->has_analysis<CFG::DominatorTree>())
+        std::cout << "Cache passed\n";
+
+    Fn->add_sucessor(Entry, K, "skip");
+    if (!Fn->has_analysis<CFG::DominatorTree>() && Fn->get_dominator_tree().get_idom(K->get_id()) == Entry->get_id())
+        std::cout << "Invalidation passed\n";
+
+    /// nested loops and an irreducible region:
+    /// A -> B -> C -> C (self loop), C -> B, B -> D, A -> E -> D -> E,
+    /// the region D-E can be entered through D and through E
+    auto Fn2 = CFG::Function::Create("Func2", M.get());
+    auto A = CFG::BasicBlock::Create("A", Fn2);
+    auto B = CFG::BasicBlock::Create("B", Fn2);
+    auto C = CFG::BasicBlock::Create("C", Fn2);
+    auto D = CFG::BasicBlock::Create("D", Fn2);
+    auto E = CFG::BasicBlock::Create("E", Fn2);
+    Fn2->add_sucessor(A, B, "true");
+    Fn2->add_sucessor(B, C, "true");
+    Fn2->add_sucessor(C, C, "self");
+    Fn2->add_sucessor(C, B, "back");
+    Fn2->add_sucessor(B, D, "false");
+    Fn2->add_sucessor(A, E, "false");
+    Fn2->add_sucessor(E, D, "");
+    Fn2->add_sucessor(D, E, "");
+
+    const auto &loops2 = Fn2->get_loop_info();
+    for (const auto &loop : loops2.get_loops())
+        std::cout << "loop header=" << Fn2->get_basic_block(loop.header)->get_name() << " depth=" << loop.depth
+                  << " blocks=" << loop.blocks.size() << (loop.irreducible ? " irreducible" : "") << "\n";
+
+    if (loops2.get_loop_depth(C) == 2 && loops2.get_loop_depth(B) == 1 && loops2.get_loop_depth(A) == 0 &&
+        loops2.get_loop_depth(E) == 1 && loops2.get_loops()[loops2.get_loop_for(E->get_id())].irreducible)
+        std::cout << "Nested loops passed\n";
+
+    /// components of Func2: {A}, {B, C}, {D, E}, A comes first
+    const auto &sccs = Fn2->get_sccs();
+    if (sccs.num_components() == 3 && sccs.same_component(B->get_id(), C->get_id()) &&
+        sccs.same_component(D->get_id(), E->get_id()) && sccs.get_component(A->get_id()) == 0 &&
+        !sccs.is_cyclic(0) && sccs.is_cyclic(sccs.get_component(B->get_id())) &&
+        sccs.get_component(B->get_id()) < sccs.get_component(D->get_id()))
+        std::cout << "Components passed\n";
+
+    /// liveness of a variable defined in A and used in D, the loops
+    /// B-C and D-E keep it live everywhere but at the start of A
+    for (const auto &bb : Fn2->get_basic_blocks())
+    {
+        bb->get_gen().resize(1);
+        bb->get_kill().resize(1);
+    }
+    A->get_kill().set(0);
+    D->get_gen().set(0);
+
+    CFG::DataflowResult<CFG::LivenessProblem> live(*Fn2, CFG::LivenessProblem(*Fn2, 1));
+    /// for a backward problem get_out is the start of the block
+    if (!live.get_out(A->get_id()).test(0) && live.get_in(A->get_id()).test(0) && live.get_out(C->get_id()).test(0) &&
+        live.get_out(E->get_id()).test(0) && live.get_out(D->get_id()).test(0))
+        std::cout << "Liveness passed\n";
+
+    /// Func1 -> Func2 -> Func3 -> Func2, Func3 -> Func3
+    auto Fn3 = CFG::Function::Create("Func3", M.get());
+    CFG::BasicBlock::Create("Entry", Fn3);
+    M->add_call(Fn, Fn2);
+    M->add_call(Fn2, Fn3);
+    M->add_call(Fn3, Fn2);
+    M->add_call(Fn3, Fn3);
+
+    CFG::CallGraph calls(*M);
+    const auto &call_sccs = calls.get_sccs();
+    if (!M->add_call(Fn, Fn2) || calls.is_recursive(Fn->get_id()) || !calls.is_recursive(Fn3->get_id()) ||
+        !call_sccs.same_component(Fn2->get_id(), Fn3->get_id()) ||
+        call_sccs.get_component(Fn->get_id()) > call_sccs.get_component(Fn2->get_id()))
+        std::cout << "Call graph FAILED\n";
+    else
+        std::cout << "Call graph passed\n";
+
+    /// removing a function removes its calls
+    M->delete_function(Fn3);
+    CFG::CallGraph calls2(*M);
+    if (!calls2.is_recursive(Fn2->get_id()) && M->get_callers(Fn2).size() == 1)
+        std::cout << "Call graph update passed\n";
+
+    /// traversal orders and edge ranges, before and after finalizing
+    static_assert(std::ranges::forward_range<CFG::Function::BlockRange>);
+    static_assert(std::ranges::view<CFG::Function::BlockRange>);
+
+    auto Fn4 = CFG::Function::Create("Func4", M.get());
+    auto E4 = CFG::BasicBlock::Create("E", Fn4);
+    auto A4 = CFG::BasicBlock::Create("A", Fn4);
+    auto B4 = CFG::BasicBlock::Create("B", Fn4);
+    auto C4 = CFG::BasicBlock::Create("C", Fn4);
+    auto D4 = CFG::BasicBlock::Create("D", Fn4);
+    Fn4->add_sucessor(E4, A4, "true");
+    Fn4->add_sucessor(E4, B4, "false");
+    Fn4->add_sucessor(A4, C4, "");
+    Fn4->add_sucessor(B4, C4, "");
+    Fn4->add_sucessor(C4, A4, "loop");
+
+    auto ids = [](auto range)
+    {
+        std::vector<CFG::block_id_t> out;
+        for (auto bb : range)
+            out.push_back(bb->get_id());
+        return out;
+    };
+    auto same = [](std::span<const CFG::block_id_t> order, std::vector<CFG::block_id_t> expected)
+    {
+        return std::ranges::equal(order, expected);
+    };
+
+    bool traversal = true;
+    for (int pass = 0; pass < 2; pass++)
+    {
+        auto preds = ids(Fn4->predecessors(C4));
+        std::ranges::sort(preds);
+        traversal = traversal && ids(Fn4->successors(E4)) == std::vector<CFG::block_id_t>{1, 2} &&
+                    preds == std::vector<CFG::block_id_t>{1, 2} && Fn4->successors(D4).empty() &&
+                    Fn4->predecessors(A4).size() == 2 &&
+                    std::ranges::count(Fn4->successors(C4) | std::views::transform(&CFG::BasicBlock::get_id), 1) == 1 &&
+                    same(Fn4->get_preorder(), {0, 1, 3, 2}) && same(Fn4->get_postorder(), {3, 1, 2, 0}) &&
+                    same(Fn4->get_reverse_postorder(), {0, 2, 1, 3}) &&
+                    !Fn4->get_analysis<CFG::BlockOrder>().is_reachable(D4->get_id());
+        Fn4->finalize();
+    }
+
+    if (traversal && Fn4->has_analysis<CFG::BlockOrder>())
+        std::cout << "Traversals passed\n";
+    else
+        std::cout << "Traversals FAILED\n";
+
+    /// the same kernels over graphs with different storage policies
+    CFG::BasicGraph<CFG::BranchGraphPolicy> branches;
+    CFG::BasicGraph<CFG::TaggedBranchGraphPolicy> kinds;
+    CFG::BasicGraph<CFG::GraphPolicy<std::uint32_t, CFG::NoTag, 1>> single;
+    CFG::BasicGraph<CFG::GraphPolicy<std::uint16_t, std::size_t>> lengths;
+    CFG::Graph packed;
+
+    bool kernels = !branches.assign(*Fn4) && !kinds.assign(*Fn4) && single.assign(*Fn4) && single.size() == 0 &&
+                   !packed.assign(*Fn4) && !lengths.assign(*Fn4, [](CFG::tag_id_t, std::string_view tag)
+                                                           { return tag.size(); });
+    kernels = kernels && branches.size() == 5 && branches.num_edges() == 5 && branches.get_entry() == 0 &&
+              std::ranges::equal(branches.successors(0), std::vector<std::uint32_t>{1, 2}) &&
+              branches.predecessors(1).size() == 2 &&
+              std::ranges::equal(CFG::reverse_postorder(branches, 0), Fn4->get_reverse_postorder()) &&
+              kinds.successor_tags(0)[1] == CFG::BranchTag::False && kinds.successor_tags(3)[0] == CFG::BranchTag::Loop &&
+              packed.get_tag_name(packed.successor_tags(0)[0]) == "true" && lengths.successor_tags(3)[0] == 4;
+    static_assert(sizeof(CFG::BasicGraph<CFG::BranchGraphPolicy>) < sizeof(CFG::Graph));
+
+    /// dominators of the kernel against the dominator tree
+    for (auto shape : {CFG::GraphShape::Compiler, CFG::GraphShape::Loops})
+    {
+        auto Gen = CFG::build_function(CFG::generate_graph(shape, 2000, 7), M.get(), CFG::shape_name(shape));
+        CFG::BasicGraph<CFG::WideGraphPolicy> wide;
+        kernels = kernels && !wide.assign(*Gen) && wide.get_entry() == 0;
+        auto idom = CFG::immediate_dominators(wide, wide.get_entry());
+        const auto &tree = Gen->get_dominator_tree();
+        for (CFG::block_id_t id = 0; id < idom.size(); id++)
+            kernels = kernels && (idom[id] == wide.none ? tree.get_idom(id) == CFG::DominatorTree::invalid
+                                                        : idom[id] == tree.get_idom(id));
+        M->delete_function(Gen);
+    }
+
+    if (kernels)
+        std::cout << "Graph kernels passed\n";
+    else
+        std::cout << "Graph kernels FAILED\n";
+
+    /// calls made by blocks, the module keeps the call while a block makes it
+    std::unique_ptr<CFG::Module> M2 = std::make_unique<CFG::Module>("calls");
+    std::vector<CFG::Function *> funcs;
+    for (int i = 0; i < 60; i++)
+    {
+        auto F = CFG::Function::Create("F" + std::to_string(i), M2.get());
+        auto Entry = CFG::BasicBlock::Create("Entry", F);
+        auto Exit = CFG::BasicBlock::Create("Exit", F);
+        F->add_sucessor(Entry, Exit, "");
+        funcs.push_back(F);
+    }
+    /// calls to higher ids, plus a cycle F10 -> F20 -> F10
+    for (int i = 0; i < 60; i++)
+        for (int j = i + 1; j < 60; j += 7 + i % 5)
+            funcs[i]->add_call(funcs[i]->get_basic_block(CFG::block_id_t(j % 2)), funcs[j]);
+    funcs[20]->add_call(funcs[20]->get_basic_block(CFG::block_id_t(0)), funcs[10]);
+
+    auto Site = funcs[0]->get_basic_block(CFG::block_id_t(0));
+    bool sites = funcs[0]->get_calls(Site).size() > 0 && funcs[0]->add_call(Site, funcs[0]->get_calls(Site)[0]) &&
+                 funcs[0]->add_call(Site, Fn);
+    auto Extra = CFG::BasicBlock::Create("Extra", funcs[1]);
+    funcs[1]->add_call(Extra, funcs[59]);
+    funcs[1]->add_call(funcs[1]->get_basic_block(CFG::block_id_t(0)), funcs[59]);
+    funcs[1]->delete_basic_block(Extra);
+    sites = sites && M2->get_callees(funcs[1]).back() == funcs[59];
+    funcs[1]->delete_basic_block(funcs[1]->get_basic_block(CFG::block_id_t(0)));
+    sites = sites && std::ranges::find(M2->get_callees(funcs[1]), funcs[59]) == M2->get_callees(funcs[1]).end();
+
+    /// merging a chain keeps the calls of the merged blocks
+    auto Chain = CFG::Function::Create("Chain", M2.get());
+    auto Head = CFG::BasicBlock::Create("Head", Chain);
+    auto Mid = CFG::BasicBlock::Create("Mid", Chain);
+    auto Tail = CFG::BasicBlock::Create("Tail", Chain);
+    Chain->add_sucessor(Head, Mid, "");
+    Chain->add_sucessor(Mid, Tail, "");
+    Chain->add_call(Head, funcs[58]);
+    Chain->add_call(Mid, funcs[58]);
+    Chain->add_call(Mid, funcs[57]);
+    Chain->add_call(Tail, funcs[56]);
+    sites = sites && !Chain->merge_blocks(Head, Mid) && Chain->get_calls(Head).size() == 2 &&
+            M2->get_callees(Chain).size() == 3 && Chain->collapse_chains() == 1 &&
+            Chain->get_calls(Head).size() == 3 && M2->get_callees(Chain).size() == 3;
+    /// the call made by two blocks before merging goes with the last one
+    Chain->delete_basic_block(Head);
+    sites = sites && M2->get_callees(Chain).empty();
+    M2->delete_function(Chain);
+
+    /// every function starts after the functions it calls out of its
+    /// component have finished
+    CFG::CallGraph graph(*M2);
+    std::atomic<int> clock{0};
+    std::vector<int> started(60), finished(60);
+    graph.run_bottom_up(*M2, [&](CFG::Function &F)
+                        {
+                            started[F.get_id()] = clock++;
+                            F.get_dominator_tree();
+                            finished[F.get_id()] = clock++; },
+                        4);
+
+    bool bottom_up = true;
+    for (auto F : funcs)
+        for (auto callee : M2->get_callees(F))
+            if (!graph.get_sccs().same_component(F->get_id(), callee->get_id()))
+                bottom_up = bottom_up && finished[callee->get_id()] < started[F->get_id()];
+
+    if (sites && bottom_up && graph.is_recursive(10) && funcs[59]->has_analysis<CFG::DominatorTree>())
+        std::cout << "Bottom-up passed\n";
+    else
+        std::cout << "Bottom-up FAILED\n";
+
+
+    /// copies of generated graphs with the blocks and edges created in
+    /// another order, the entry block is always created first
+    std::unique_ptr<CFG::Module> M3 = std::make_unique<CFG::Module>("dedup");
+    std::mt19937_64 rng(11);
+    auto build_shuffled = [&](const CFG::GeneratedGraph &G, std::string_view name)
+    {
+        std::vector<CFG::block_id_t> slot(G.num_blocks);
+        std::iota(slot.begin(), slot.end(), 0);
+        std::shuffle(slot.begin() + 1, slot.end(), rng);
+
+        auto F = CFG::Function::Create(name, M3.get());
+        std::vector<CFG::BasicBlock *> blocks(G.num_blocks);
+        for (auto id : slot)
+            blocks[id] = CFG::BasicBlock::Create("b" + std::to_string(id), F);
+
+        auto edges = G.edges;
+        std::shuffle(edges.begin(), edges.end(), rng);
+        for (const auto &edge : edges)
+            F->add_sucessor(blocks[edge.src], blocks[edge.dst], G.get_tag(edge));
+        return F;
+    };
+
+    bool dedup = true;
+    std::vector<CFG::Function *> originals;
+    for (auto shape : {CFG::GraphShape::Compiler, CFG::GraphShape::Loops, CFG::GraphShape::Switch})
+    {
+        auto G = CFG::generate_graph(shape, 300, 5);
+        auto Original = CFG::build_function(G, M3.get(), CFG::shape_name(shape));
+        auto Copy = build_shuffled(G, "copy");
+        originals.push_back(Original);
+
+        std::vector<CFG::block_id_t> mapping;
+        dedup = dedup && Original->get_analysis<CFG::StructuralHash>().get_hash() == Copy->get_analysis<CFG::StructuralHash>().get_hash() &&
+                CFG::is_isomorphic(*Original, *Copy, &mapping) && mapping.size() == G.num_blocks;
+        for (CFG::block_id_t id = 0; dedup && id < mapping.size(); id++)
+            dedup = Copy->get_basic_block(mapping[id])->get_name() == "b" + std::to_string(id);
+
+        /// another tag on one edge, then one edge less
+        G.tags.push_back("other");
+        G.edges[G.edges.size() / 2].tag = static_cast<std::uint32_t>(G.tags.size() - 1);
+        auto Retagged = build_shuffled(G, "retagged");
+        G.edges.pop_back();
+        auto Pruned = build_shuffled(G, "pruned");
+        dedup = dedup && !CFG::is_isomorphic(*Original, *Retagged) && !CFG::is_isomorphic(*Original, *Pruned);
+    }
+
+    /// same shapes with other seeds are different functions
+    auto Other = CFG::build_function(CFG::generate_graph(CFG::GraphShape::Compiler, 300, 6), M3.get(), "other");
+    dedup = dedup && !CFG::is_isomorphic(*originals[0], *Other);
+
+    /// 3 originals, one copy of each, 3 retagged, 3 pruned and `other`
+    for (auto threads : {1u, 4u})
+    {
+        CFG::DedupIndex index(*M3, threads);
+        dedup = dedup && index.num_functions() == 13 && index.num_classes() == 10 && index.num_duplicates() == 3;
+        for (std::uint32_t i = 0; i < 3; i++)
+        {
+            auto original = originals[i]->get_id();
+            dedup = dedup && index.is_canonical(original) && index.get_canonical(original + 1) == original &&
+                    index.get_canonical(M3->get_function(original + 1)) == originals[i] &&
+                    index.get_hash(original) == index.get_hash(original + 1) && index.is_canonical(original + 2);
+        }
+    }
+
+    if (dedup)
+        std::cout << "Dedup passed\n";
+    else
+        std::cout << "Dedup FAILED\n";
+
+    return 0;
+}
@@ -0,0 +1,216 @@
+//--------------------------------------------------------------------*- C++ -*-
+// CFG: example of CFG
+//
+// @file test5.cpp
+// @brief Test5 for testing the binary format with the graphs of test1-test3
+
+#include "cfg/Serialization.hpp"
+
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+namespace
+{
+    /// @brief Compare a function with its mapped version
+    bool same_function(const CFG::Function &Fn, const CFG::MappedModule::FunctionView &view)
+    {
+        if (Fn.get_name() != view.get_name() || Fn.get_num_basic_blocks() != view.num_blocks())
+            return false;
+
+        /// the file numbers the blocks by their position
+        CFG::CSREdges edges;
+        Fn.pack_edges(edges, true);
+
+        CFG::block_id_t id = 0;
+        for (const auto &bb : Fn.get_basic_blocks())
+        {
+            auto block = view.get_basic_block(id);
+
+            if (bb->get_name() != block.get_name() || bb->get_start_addr() != block.get_start_addr() ||
+                bb->get_end_addr() != block.get_end_addr() || bb->get_entry_block() != block.get_entry_block())
+                return false;
+
+            if (block.num_sucessors() != edges.succ_end(id) - edges.succ_begin(id) ||
+                block.num_predecessors() != edges.pred_end(id) - edges.pred_begin(id))
+                return false;
+
+            for (std::size_t i = 0; i < block.num_sucessors(); i++)
+            {
+                auto edge = block.get_sucessor(i);
+                auto e = edges.succ_begin(id) + i;
+                if (edge.target != edges.succ_targets[e] || edge.tag != edges.tags.get(edges.succ_tags[e]))
+                    return false;
+            }
+            id++;
+        }
+
+        return true;
+    }
+
+    /// @brief Write a module, map it back and compare both, then
+    /// compare the module rebuilt from the file with the original one
+    void round_trip(const CFG::Module &M)
+    {
+        auto path = M.get_name() + ".cfgb";
+
+        try
+        {
+            CFG::write_module(M, path);
+
+            CFG::MappedModule mapped(path);
+            bool ok = mapped.get_name() == M.get_name() && mapped.num_functions() == M.get_num_functions();
+            std::size_t f = 0;
+            for (const auto &func : M.get_functions())
+                ok = ok && same_function(*func, mapped.get_function(f++));
+
+            auto copy = mapped.to_module();
+            CFG::write_module(*copy, path);
+            CFG::MappedModule remapped(path);
+            f = 0;
+            for (const auto &func : M.get_functions())
+                ok = ok && same_function(*func, remapped.get_function(f++));
+
+            std::cout << "Module " << M.get_name() << (ok ? " round trip passed\n" : " round trip FAILED\n");
+        }
+        catch (std::exception &e)
+        {
+            std::cerr << e.what() << "\n";
+        }
+    }
+
+    /// @brief Write a corrupted copy of a file and check that mapping it
+    /// or getting its functions throws instead of reading out of the file
+    bool rejects(const std::string &path, const std::function<void(std::vector<char> &, const CFG::format::Header &)> &corrupt)
+    {
+        std::ifstream in(path, std::ios::binary);
+        std::vector<char> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        CFG::format::Header header;
+        std::memcpy(&header, bytes.data(), sizeof(header));
+        corrupt(bytes, header);
+
+        std::ofstream("corrupt.cfgb", std::ios::binary | std::ios::trunc).write(bytes.data(), bytes.size());
+        try
+        {
+            CFG::MappedModule mapped("corrupt.cfgb");
+            for (std::size_t f = 0; f < mapped.num_functions(); f++)
+                mapped.get_function(f);
+            return false;
+        }
+        catch (const exceptions::SerializationException &)
+        {
+            return true;
+        }
+    }
+
+    template <typename T>
+    void patch(std::vector<char> &bytes, std::uint64_t offset, T value)
+    {
+        std::memcpy(bytes.data() + offset, &value, sizeof(value));
+    }
+} // namespace
+
+int
+main()
+{
+    /// graph of test1
+    std::unique_ptr<CFG::Module> M1 = std::make_unique<CFG::Module>("test1");
+    auto Fn = CFG::Function::Create("Func1", M1.get());
+    auto BB1 = CFG::BasicBlock::Create("BB1", Fn);
+    auto BB2 = CFG::BasicBlock::Create("BB2", Fn);
+    BB1->set_start_addr(0x1000);
+    BB1->set_end_addr(0x1010);
+    BB2->set_start_addr(0x1010);
+    BB2->set_end_addr(0x1020);
+    round_trip(*M1);
+
+    /// graph of test2, finalized
+    std::unique_ptr<CFG::Module> M2 = std::make_unique<CFG::Module>("test2");
+    Fn = CFG::Function::Create("Func1", M2.get());
+    auto Entry = CFG::BasicBlock::Create("Entry", Fn);
+    auto H = CFG::BasicBlock::Create("H", Fn);
+    auto I = CFG::BasicBlock::Create("I", Fn);
+    auto J = CFG::BasicBlock::Create("J", Fn);
+    Fn->add_sucessor(Entry, H, "true");
+    Fn->add_sucessor(Entry, I, "false");
+    Fn->add_sucessor(H, J, "");
+    Fn->add_sucessor(I, J, "");
+    Fn->delete_basic_block(H);
+    auto K = CFG::BasicBlock::Create("K", Fn);
+    Fn->add_sucessor(J, K, "loop");
+    Fn->add_sucessor(K, J, "loop");
+    Fn->finalize();
+    round_trip(*M2);
+
+    /// corrupted records of the file of test2
+    using CFG::format::FunctionRecord;
+    using CFG::format::Header;
+    bool corrupt = rejects("test2.cfgb", [](auto &bytes, const Header &h)
+                           { bytes.resize(h.pred_sources); }) &&
+                   rejects("test2.cfgb", [](auto &bytes, const Header &h)
+                           { patch<CFG::block_id_t>(bytes, h.succ_targets, 4); }) &&
+                   rejects("test2.cfgb", [](auto &bytes, const Header &h)
+                           { patch<CFG::tag_id_t>(bytes, h.succ_tags, h.num_tags); }) &&
+                   rejects("test2.cfgb", [](auto &bytes, const Header &h)
+                           { patch<std::uint32_t>(bytes, h.succ_offsets + 4, 100); }) &&
+                   rejects("test2.cfgb", [](auto &bytes, const Header &h)
+                           { patch<std::uint32_t>(bytes, h.functions + offsetof(FunctionRecord, num_blocks), 5); }) &&
+                   rejects("test2.cfgb", [](auto &bytes, const Header &h)
+                           { patch<std::uint32_t>(bytes, h.functions + offsetof(FunctionRecord, name), h.strings_size); }) &&
+                   rejects("test2.cfgb", [](auto &bytes, const Header &h)
+                           { patch<std::uint32_t>(bytes, h.tags + sizeof(std::uint32_t), 1000); }) &&
+                   rejects("test2.cfgb", [](auto &bytes, const Header &h)
+                           { patch<CFG::block_id_t>(bytes, h.pred_sources, 3); });
+    std::cout << (corrupt ? "Corrupt files passed\n" : "Corrupt files FAILED\n");
+
+    /// graphs of test3, including the invalid ones, with
+    /// a deleted block and a deleted function in the middle
+    std::unique_ptr<CFG::Module> M3 = std::make_unique<CFG::Module>("test3");
+    Fn = CFG::Function::Create("Func1", M3.get());
+    Entry = CFG::BasicBlock::Create("Entry", Fn);
+    H = CFG::BasicBlock::Create("H", Fn);
+    auto Gone = CFG::BasicBlock::Create("Gone", Fn);
+    I = CFG::BasicBlock::Create("I", Fn);
+    J = CFG::BasicBlock::Create("J", Fn);
+    Fn->add_sucessor(Entry, H, "true");
+    Fn->add_sucessor(Entry, I, "false");
+    Fn->add_sucessor(H, J, "");
+    Fn->add_sucessor(I, J, "");
+    Fn->add_sucessor(Gone, J, "");
+    Fn->delete_basic_block(Gone);
+    auto GoneFunc = CFG::Function::Create("GoneFunc", M3.get());
+
+    auto Fn2 = CFG::Function::Create("Func2", M3.get());
+    auto Entry2 = CFG::BasicBlock::Create("Entry", Fn2);
+    auto FakeEntry = CFG::BasicBlock::Create("FakeEntry", Fn2);
+    FakeEntry->set_entry_block(true);
+    Fn2->add_sucessor(Entry2, FakeEntry, "");
+
+    auto Fn3 = CFG::Function::Create("Func3", M3.get());
+    auto Entry3 = CFG::BasicBlock::Create("Entry", Fn3);
+    auto H2 = CFG::BasicBlock::Create("H", Fn3);
+    auto I2 = CFG::BasicBlock::Create("I", Fn3);
+    CFG::BasicBlock::Create("J", Fn3);
+    Fn3->add_sucessor(Entry3, H2, "true");
+    Fn3->add_sucessor(Entry3, I2, "false");
+
+    auto Fn4 = CFG::Function::Create("Func4", M3.get());
+    auto Entry4 = CFG::BasicBlock::Create("Entry", Fn4);
+    Entry4->set_entry_block(false);
+
+    CFG::Function::Create("Empty", M3.get());
+    M3->delete_function(GoneFunc);
+    round_trip(*M3);
+
+    /// validation gives the same result on the loaded module
+    CFG::write_module(*M3, "test3.cfgb");
+    auto loaded = CFG::MappedModule("test3.cfgb").to_module();
+    std::cout << loaded->validate_all(1);
+
+    return 0;
+}
@@ -0,0 +1,136 @@
+//--------------------------------------------------------------------*- C++ -*-
+// CFG: example of CFG
+//
+// @file test6.cpp
+// @brief Test6 for testing the buffered exporter and the text loader
+
+#include "cfg/Exporter.hpp"
+#include "cfg/Module.hpp"
+#include "cfg/Parser.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+
+int
+main()
+{
+    std::unique_ptr<CFG::Module> M = std::make_unique<CFG::Module>("test6");
+    auto Fn = CFG::Function::Create("Func1", M.get());
+    auto Entry = CFG::BasicBlock::Create("Entry", Fn);
+    auto H = CFG::BasicBlock::Create("H", Fn);
+    auto I = CFG::BasicBlock::Create("I \"quoted\"", Fn);
+    Entry->set_start_addr(0x1000);
+    Entry->set_end_addr(0x1010);
+    Fn->add_sucessor(Entry, H, "true");
+    Fn->add_sucessor(Entry, I, "false");
+    Fn->add_sucessor(H, I, "");
+
+    auto Fn2 = CFG::Function::Create("Func2", M.get());
+    auto Entry2 = CFG::BasicBlock::Create("Entry", Fn2);
+    Fn2->add_sucessor(Entry2, Entry2, "loop");
+    Fn2->finalize();
+
+    /// a small buffer so the text is flushed many times
+    std::ostringstream edge_list, json;
+    {
+        CFG::StreamSink sink(edge_list);
+        CFG::OutputBuffer out(sink, 16);
+        CFG::export_module(*M, out, CFG::ExportFormat::EdgeList);
+    }
+    {
+        CFG::StreamSink sink(json);
+        CFG::OutputBuffer out(sink);
+        CFG::export_module(*M, out, CFG::ExportFormat::Json);
+    }
+
+    std::cout << edge_list.str();
+    std::cout << json.str();
+
+    std::string expected = "module \"test6\"\n"
+                           "function \"Func1\"\n"
+                           "block 0 \"Entry\" 0x1000 0x1010 entry\n"
+                           "block 1 \"H\" 0x0 0x0\n"
+                           "block 2 \"I \\\"quoted\\\"\" 0x0 0x0\n"
+                           "edge 0 1 \"true\"\n"
+                           "edge 0 2 \"false\"\n"
+                           "edge 1 2 \"\"\n"
+                           "end\n"
+                           "function \"Func2\"\n"
+                           "block 0 \"Entry\" 0x0 0x0 entry\n"
+                           "edge 0 0 \"loop\"\n"
+                           "end\n";
+    std::cout << (edge_list.str() == expected ? "Edge list passed\n" : "Edge list FAILED\n");
+
+    /// load both texts back and export them again
+    for (auto text : {edge_list.str(), json.str()})
+    {
+        auto loaded = CFG::parse_module(text, CFG::InputFormat::Auto, 2);
+        std::ostringstream again;
+        {
+            CFG::StreamSink sink(again);
+            CFG::OutputBuffer out(sink);
+            CFG::export_module(*loaded, out, text[0] == '{' ? CFG::ExportFormat::Json : CFG::ExportFormat::EdgeList);
+        }
+        std::cout << (again.str() == text ? "Load passed\n" : "Load FAILED\n");
+    }
+
+    /// errors give the line of the input
+    try
+    {
+        CFG::parse_module("function \"F\"\nblock 0 \"A\" 0x0 0x0 entry\nedge 0 1 \"\"\nend\n");
+    }
+    catch (exceptions::ParseException &e)
+    {
+        std::cout << e.what() << "\n";
+    }
+    try
+    {
+        CFG::parse_module("module \"m\"\nfunction \"F\"\nblock 0 \"A\" 0x0 0x0 entry\nblock 2 \"B\" 0x0 0x0\nend\n");
+    }
+    catch (exceptions::ParseException &e)
+    {
+        std::cout << e.what() << "\n";
+    }
+
+    /// one file per function
+    auto dir = std::filesystem::temp_directory_path() / "cfg-test6";
+    std::filesystem::create_directories(dir);
+    CFG::export_module_split(*M, dir.string(), CFG::ExportFormat::Dot, 2);
+
+    std::ifstream ifs(dir / "1-Func2.dot");
+    std::stringstream dot;
+    dot << ifs.rdbuf();
+    std::cout << dot.str();
+    std::filesystem::remove_all(dir);
+
+    /// Graphviz has no escapes for control characters
+    CFG::Module M2("test6-dot");
+    auto Fn3 = CFG::Function::Create("Func3", &M2);
+    auto Tab = CFG::BasicBlock::Create("A\tB\x01", Fn3);
+    Fn3->add_sucessor(Tab, Tab, "line\nbreak");
+    std::ostringstream dot2;
+    {
+        CFG::StreamSink sink(dot2);
+        CFG::OutputBuffer out(sink);
+        CFG::export_function(*Fn3, out, CFG::ExportFormat::Dot);
+    }
+    bool dot_ok = dot2.str().find("\\u00") == std::string::npos && dot2.str().find("\"A B \"") != std::string::npos &&
+                  dot2.str().find("label=\"line\\nbreak\"") != std::string::npos;
+    std::cout << (dot_ok ? "DOT escapes passed\n" : "DOT escapes FAILED\n");
+
+    /// numbers in every base, base 2 takes 64 digits
+    std::ostringstream numbers;
+    {
+        CFG::StreamSink sink(numbers);
+        CFG::OutputBuffer out(sink, 16);
+        out.write_uint(~0ull, 2).write('|').write_uint(~0ull, 3).write('|').write_uint(0, 2);
+    }
+    std::cout << (numbers.str() == std::string(64, '1') + "|11112220022122120101211020120210210211220|0"
+                      ? "Numbers passed\n"
+                      : "Numbers FAILED\n");
+
+    return 0;
+}